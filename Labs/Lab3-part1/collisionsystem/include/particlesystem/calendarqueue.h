@@ -0,0 +1,295 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <span>
+#include <cstdint>
+#include <iterator>
+#include <utility>
+
+#include <particlesystem/radixheap.h>  // ScheduledTime
+
+/**
+ * A priority queue implemented as a calendar queue (R. Brown, 1988)
+ *
+ * Time is divided in days of length width and day d is stored in bucket d % n_buckets,
+ * like the days of a year in a desk calendar. Each bucket is sorted decreasingly, so that its
+ * smallest element is at the back. deleteMin visits the buckets of the current year in order,
+ * starting at the day of the last element removed.
+ *
+ * The number of buckets follows the size of the queue, and each time the buckets are resized
+ * the width is tuned to about three times the average separation of the earliest elements,
+ * which gives O(1) average insert and deleteMin when the elements are spread over a window
+ * after the last element removed, as event times in the simulation are.
+ */
+template <class Comparable, class KeyOf = ScheduledTime>
+class CalendarQueue {
+public:
+    /**
+     * Constructor to create an empty queue
+     * initCapacity is accepted for compatibility with PriorityQueue
+     */
+    explicit CalendarQueue([[maybe_unused]] int initCapacity = 100) { makeEmpty(); }
+
+    // Disable copying
+    CalendarQueue(const CalendarQueue&) = delete;
+    CalendarQueue& operator=(const CalendarQueue&) = delete;
+
+    /**
+     * Make the queue empty
+     */
+    void makeEmpty();
+
+    /**
+     * Check is the queue is empty
+     * Return true if the queue is empty, false otherwise
+     */
+    bool isEmpty() const { return count == 0; }
+
+    /**
+     * Get the size of the queue, i.e. number of elements in the queue
+     */
+    size_t size() const { return count; }
+
+    /**
+     * Get the smallest element in the queue
+     */
+    Comparable findMin();
+
+    /**
+     * Remove and return the smallest element in the queue
+     */
+    Comparable deleteMin();
+
+    /**
+     * Add a new element x to the queue
+     */
+    void insert(const Comparable& x) { emplace(x); }
+
+    /**
+     * Add a new element x to the queue, moving it into the queue
+     */
+    void insert(Comparable&& x) { emplace(std::move(x)); }
+
+    /**
+     * Add a new element constructed in place from args to the queue
+     */
+    template <class... Args>
+    void emplace(Args&&... args);
+
+    /**
+     * Add all elements of batch to the queue
+     */
+    void insertBatch(std::span<const Comparable> batch) {
+        for (const Comparable& x : batch) {
+            emplace(x);
+        }
+    }
+
+    /**
+     * Remove all elements x for which pred(x) is true
+     * pred is called once for each element. Return the number of elements removed
+     */
+    template <class Predicate>
+    std::size_t removeIf(Predicate pred);
+
+    /**
+     * Get the current length of a day, i.e. the time range of a bucket
+     */
+    double bucketWidth() const { return width; }
+
+private:
+    static constexpr std::size_t min_buckets = 2;
+    static constexpr std::size_t n_samples = 25;  // elements sampled to tune the width
+
+    std::vector<std::vector<Comparable>> buckets;
+    double width = 1.0;            // length of a day
+    std::uint64_t currentDay = 0;  // day of the last element removed
+    size_t count = 0;
+
+    static double keyOf(const Comparable& x) { return KeyOf{}(x); }
+
+    // Day of time t
+    std::uint64_t dayOf(double t) const {
+        const double day = std::floor(std::max(t, 0.0) / width);
+        return day < 1.8e19 ? static_cast<std::uint64_t>(day) : std::uint64_t{1} << 63;
+    }
+
+    // Insert x into its bucket, keeping the bucket sorted decreasingly
+    void place(Comparable x);
+
+    // Index of the bucket holding the smallest element, currentDay is moved to its day
+    std::size_t locateMin();
+
+    // Rebuild the calendar with n buckets and a width tuned to the current elements
+    void resize(std::size_t n);
+};
+
+/* *********************** Member functions implementation *********************** */
+
+/**
+ * Make the queue empty
+ */
+template <class Comparable, class KeyOf>
+void CalendarQueue<Comparable, KeyOf>::makeEmpty() {
+    buckets.assign(min_buckets, {});
+    width = 1.0;
+    currentDay = 0;
+    count = 0;
+}
+
+/**
+ * Get the smallest element in the queue
+ */
+template <class Comparable, class KeyOf>
+Comparable CalendarQueue<Comparable, KeyOf>::findMin() {
+    assert(!isEmpty());
+    return buckets[locateMin()].back();
+}
+
+/**
+ * Remove and return the smallest element in the queue
+ */
+template <class Comparable, class KeyOf>
+Comparable CalendarQueue<Comparable, KeyOf>::deleteMin() {
+    assert(!isEmpty());
+    auto& bucket = buckets[locateMin()];
+
+    Comparable minElement = std::move(bucket.back());
+    bucket.pop_back();
+    --count;
+
+    if (buckets.size() > min_buckets && count < buckets.size() / 2) {
+        resize(buckets.size() / 2);
+    }
+    return minElement;
+}
+
+/**
+ * Add a new element constructed in place from args to the queue
+ */
+template <class Comparable, class KeyOf>
+template <class... Args>
+void CalendarQueue<Comparable, KeyOf>::emplace(Args&&... args) {
+    Comparable x(std::forward<Args>(args)...);
+
+    // an element earlier than the last one removed moves the calendar back to its day
+    currentDay = std::min(currentDay, dayOf(keyOf(x)));
+    place(std::move(x));
+    ++count;
+
+    if (count > 2 * buckets.size()) {
+        resize(2 * buckets.size());
+    }
+}
+
+/**
+ * Remove all elements x for which pred(x) is true
+ * The buckets stay sorted, the calendar shrinks as after the same number of deleteMin
+ */
+template <class Comparable, class KeyOf>
+template <class Predicate>
+std::size_t CalendarQueue<Comparable, KeyOf>::removeIf(Predicate pred) {
+    std::size_t removed = 0;
+    for (auto& bucket : buckets) {
+        removed += std::erase_if(bucket, pred);
+    }
+    count -= removed;
+
+    std::size_t n = buckets.size();
+    while (n > min_buckets && count < n / 2) {
+        n /= 2;
+    }
+    if (n != buckets.size()) {
+        resize(n);
+    }
+    return removed;
+}
+
+/* ******************* Private member functions ********************* */
+
+/**
+ * Insert x into its bucket, keeping the bucket sorted decreasingly
+ */
+template <class Comparable, class KeyOf>
+void CalendarQueue<Comparable, KeyOf>::place(Comparable x) {
+    auto& bucket = buckets[dayOf(keyOf(x)) % buckets.size()];
+    const auto pos = std::upper_bound(bucket.begin(), bucket.end(), x, std::greater<Comparable>{});
+    bucket.insert(pos, std::move(x));
+}
+
+/**
+ * Index of the bucket holding the smallest element, currentDay is moved to its day
+ * The buckets of the current year are visited in order, if none of them holds an element
+ * of the current year the smallest element is found by a direct search
+ */
+template <class Comparable, class KeyOf>
+std::size_t CalendarQueue<Comparable, KeyOf>::locateMin() {
+    const std::size_t n = buckets.size();
+
+    for (std::size_t k = 0; k < n; ++k, ++currentDay) {
+        const auto& bucket = buckets[currentDay % n];
+        if (!bucket.empty() && dayOf(keyOf(bucket.back())) <= currentDay) {
+            return currentDay % n;
+        }
+    }
+
+    // direct search: jump to the day of the smallest element
+    std::size_t smallest = n;
+    for (std::size_t i = 0; i < n; ++i) {
+        if (!buckets[i].empty() &&
+            (smallest == n || buckets[i].back() < buckets[smallest].back())) {
+            smallest = i;
+        }
+    }
+    assert(smallest < n);
+    currentDay = dayOf(keyOf(buckets[smallest].back()));
+    return smallest;
+}
+
+/**
+ * Rebuild the calendar with n buckets and a width tuned to the current elements:
+ * three times the average separation of the earliest elements, ignoring separations
+ * larger than twice the average
+ */
+template <class Comparable, class KeyOf>
+void CalendarQueue<Comparable, KeyOf>::resize(std::size_t n) {
+    std::vector<Comparable> all;
+    all.reserve(count);
+    for (auto& bucket : buckets) {
+        std::move(bucket.begin(), bucket.end(), std::back_inserter(all));
+    }
+
+    const std::size_t samples = std::min(n_samples, all.size());
+    if (samples > 1) {
+        std::partial_sort(all.begin(), all.begin() + samples, all.end());
+
+        double total = keyOf(all[samples - 1]) - keyOf(all[0]);
+        const double average = total / (samples - 1);
+
+        int used = 0;
+        total = 0.0;
+        for (std::size_t i = 1; i < samples; ++i) {
+            const double separation = keyOf(all[i]) - keyOf(all[i - 1]);
+            if (separation <= 2.0 * average) {
+                total += separation;
+                ++used;
+            }
+        }
+        if (used > 0 && total > 0.0) {
+            width = 3.0 * total / used;
+        }
+    }
+
+    buckets.assign(n, {});
+    if (!all.empty()) {
+        currentDay = dayOf(keyOf(*std::min_element(all.begin(), all.end())));
+    }
+    for (Comparable& x : all) {
+        place(std::move(x));
+    }
+}
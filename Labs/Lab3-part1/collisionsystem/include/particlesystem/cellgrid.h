@@ -0,0 +1,151 @@
+#pragma once
+
+#include <vector>
+#include <span>
+#include <algorithm>
+#include <cassert>
+#include <limits>
+
+#include <particlesystem/particle.h>
+
+namespace particlesystem {
+
+/**
+ * A uniform grid of m x m cells over the unit box, the broad phase of the collision system
+ *
+ * The side of a cell is not smaller than the distance between the centers of two touching
+ * particles, so a particle can only collide with particles in its own cell or in the 8
+ * neighbouring cells. A particle stays in its cell until a cell-crossing event moves it to
+ * an adjacent cell, its predictions are then completed with the particles in the cells that
+ * became its neighbours.
+ *
+ * Particles are identified by their index in the span given to build.
+ */
+class CellGrid {
+public:
+    /**
+     * Place the particles in a grid with about one particle per cell
+     */
+    void build(std::span<const Particle> particles);
+
+    /**
+     * Number of cells along each side of the unit box
+     */
+    int resolution() const { return m; }
+
+    /**
+     * Column of the cell of particle i
+     */
+    int column(int i) const { return cellX[i]; }
+
+    /**
+     * Column of the cell that particle i, currently at p, is crossing into
+     * It is the column of i if the particle crosses into the next row
+     */
+    int nextColumn(int i, const Particle& p) const;
+
+    /**
+     * Returns the amount of time for particle i, currently at p, to cross into an adjacent cell
+     * Return std::numeric_limits<double>::infinity(), if the particle does not leave its cell
+     */
+    double timeToCross(int i, const Particle& p) const;
+
+    /**
+     * A move of particle i by cross: the cell it left and its position in the particles of
+     * that cell
+     */
+    struct Crossing {
+        int i;
+        int x, y;
+        int position;
+    };
+
+    /**
+     * Move particle i, currently at p, to the adjacent cell it is crossing into
+     * and call f(j) for every particle j in the cells that became neighbours of i
+     */
+    template <class Function>
+    Crossing cross(int i, const Particle& p, Function f);
+
+    /**
+     * Move the particle of crossing back to the cell it left
+     * The later crossings must be undone first, then the cells are as before crossing
+     */
+    void undo(const Crossing& crossing);
+
+    /**
+     * Call f(j) for every particle j != i in the cell of particle i and its neighbouring cells
+     */
+    template <class Function>
+    void forNeighbours(int i, Function f) const;
+
+private:
+    int m = 1;                            // number of cells along each side
+    std::vector<std::vector<int>> cells;  // cells[x + m*y]: particles in cell (x, y)
+    std::vector<int> cellX;               // cellX[i], cellY[i]: cell of particle i
+    std::vector<int> cellY;
+
+    // Amount of time for a particle at position r, with velocity v, in column/row c of the grid
+    // to cross into the next column/row
+    double timeToCross(int c, double r, double v) const;
+
+    // Call f(j) for every particle j != i in the cells (x, y), x0 <= x <= x1, y0 <= y <= y1,
+    // clamped to the grid
+    template <class Function>
+    void forCells(int x0, int x1, int y0, int y1, int i, Function f) const;
+};
+
+/**
+ * Move particle i, currently at p, to the adjacent cell it is crossing into
+ * and call f(j) for every particle j in the cells that became neighbours of i
+ */
+template <class Function>
+CellGrid::Crossing CellGrid::cross(int i, const Particle& p, Function f) {
+    const double tX = timeToCross(cellX[i], p.r.x, p.v.x);
+    const double tY = timeToCross(cellY[i], p.r.y, p.v.y);
+    assert(tX < std::numeric_limits<double>::infinity() ||
+           tY < std::numeric_limits<double>::infinity());
+
+    auto& from = cells[cellX[i] + m * cellY[i]];
+    const auto position = std::ranges::find(from, i);
+    const Crossing crossing{i, cellX[i], cellY[i], static_cast<int>(position - from.begin())};
+    from.erase(position);
+
+    if (tX <= tY) {  // crossing into the next column
+        const int dx = p.v.x > 0 ? 1 : -1;
+        cellX[i] += dx;
+        forCells(cellX[i] + dx, cellX[i] + dx, cellY[i] - 1, cellY[i] + 1, i, f);
+    } else {  // crossing into the next row
+        const int dy = p.v.y > 0 ? 1 : -1;
+        cellY[i] += dy;
+        forCells(cellX[i] - 1, cellX[i] + 1, cellY[i] + dy, cellY[i] + dy, i, f);
+    }
+
+    cells[cellX[i] + m * cellY[i]].push_back(i);
+    return crossing;
+}
+
+/**
+ * Call f(j) for every particle j != i in the cell of particle i and its neighbouring cells
+ */
+template <class Function>
+void CellGrid::forNeighbours(int i, Function f) const {
+    forCells(cellX[i] - 1, cellX[i] + 1, cellY[i] - 1, cellY[i] + 1, i, f);
+}
+
+/**
+ * Call f(j) for every particle j != i in the cells (x, y), x0 <= x <= x1, y0 <= y <= y1,
+ * clamped to the grid
+ */
+template <class Function>
+void CellGrid::forCells(int x0, int x1, int y0, int y1, int i, Function f) const {
+    for (int y = std::max(y0, 0); y <= std::min(y1, m - 1); ++y) {
+        for (int x = std::max(x0, 0); x <= std::min(x1, m - 1); ++x) {
+            for (int j : cells[x + m * y]) {
+                if (j != i) f(j);
+            }
+        }
+    }
+}
+
+}  // namespace particlesystem
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <vector>
+#include <span>
+#include <filesystem>
+#include <optional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include <particlesystem/particle.h>
+
+namespace particlesystem {
+
+/**
+ * The state of a simulation at a time: the particles, with their collision counters,
+ * all at their positions at that time
+ */
+struct Checkpoint {
+    double time = 0.0;
+    std::vector<Particle> particles;
+};
+
+/**
+ * Write a checkpoint of particles at time to file, in a binary format
+ * The file is written next to file and then renamed, so that file always holds a complete
+ * checkpoint. Return false if the file cannot be written
+ *
+ * The format is a header (magic number, version, number of particles, time) followed by one
+ * record of 64 bytes per particle, in the byte order of the machine
+ */
+bool write_checkpoint(const std::filesystem::path& file, std::span<const Particle> particles,
+                      double time);
+
+/**
+ * Read a checkpoint written by write_checkpoint
+ * Return std::nullopt if the file cannot be read or is not a checkpoint
+ */
+std::optional<Checkpoint> read_checkpoint(const std::filesystem::path& file);
+
+/**
+ * Writes checkpoints to a file on a thread of its own, so that the simulation does not wait
+ * for the disk
+ *
+ * If a checkpoint is handed over while the previous one is still waiting to be written, the
+ * previous one is replaced: the file only needs the latest state.
+ */
+class CheckpointWriter {
+public:
+    /**
+     * Constructor to create a writer of checkpoints to file
+     */
+    explicit CheckpointWriter(std::filesystem::path file);
+
+    /**
+     * Destructor, writes the pending checkpoint before returning
+     */
+    ~CheckpointWriter();
+
+    // Disable copying
+    CheckpointWriter(const CheckpointWriter&) = delete;
+    CheckpointWriter& operator=(const CheckpointWriter&) = delete;
+
+    /**
+     * Hand over a checkpoint of particles at time, without waiting for it to be written
+     */
+    void write(std::vector<Particle> particles, double time);
+
+    /**
+     * Wait until the checkpoints handed over are written
+     */
+    void wait();
+
+    /**
+     * Number of checkpoints written, and number of checkpoints that could not be written
+     */
+    int written() const;
+    int failed() const;
+
+private:
+    std::filesystem::path file;
+    mutable std::mutex mutex;
+    std::condition_variable wake;       // a checkpoint was handed over, or the writer stops
+    std::condition_variable idle;       // the writing thread has nothing left to write
+    std::optional<Checkpoint> pending;  // the checkpoint waiting to be written
+    bool busy = false;                  // a checkpoint is being written
+    int nWritten = 0;
+    int nFailed = 0;
+    bool stop = false;
+    std::thread thread;  // started last, it uses the members above
+
+    // Loop of the writing thread
+    void run();
+};
+
+}  // namespace particlesystem
@@ -5,20 +5,56 @@
 #include <vector>
 #include <span>
 #include <functional>
+#include <memory>
+#include <thread>
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <chrono>
+#include <limits>
 
 //#define USE_PRIORITY_QUEUE_VECTOR
+//#define USE_PAIRING_HEAP
+//#define USE_RADIX_HEAP
+//#define USE_CALENDAR_QUEUE
 
-#ifdef USE_PRIORITY_QUEUE_VECTOR
+#include <particlesystem/priorityqueue.h>
+
+#if defined(USE_PRIORITY_QUEUE_VECTOR)
     #include <particlesystem/priorityqueue-vector.h>
-#else
-    #include <particlesystem/priorityqueue.h>
+#elif defined(USE_PAIRING_HEAP)
+    #include <particlesystem/pairingheap.h>
+#elif defined(USE_RADIX_HEAP)
+    #include <particlesystem/radixheap.h>
+#elif defined(USE_CALENDAR_QUEUE)
+    #include <particlesystem/calendarqueue.h>
 #endif
 
+#include <particlesystem/indexedpriorityqueue.h>
+#include <particlesystem/cellgrid.h>
+#include <particlesystem/particlestore.h>
+#include <particlesystem/threadpool.h>
+#include <particlesystem/checkpoint.h>
 #include <particlesystem/event.h>
 #include <particlesystem/particle.h>
 
 namespace particlesystem {
 
+/**
+ * Event queue of the simulation with lazy invalidation of events
+ */
+#if defined(USE_PRIORITY_QUEUE_VECTOR)
+using EventQueue = SortedVectorQueue<Event>;
+#elif defined(USE_PAIRING_HEAP)
+using EventQueue = PairingHeap<Event>;
+#elif defined(USE_RADIX_HEAP)
+using EventQueue = RadixHeap<Event>;
+#elif defined(USE_CALENDAR_QUEUE)
+using EventQueue = CalendarQueue<Event>;
+#else
+using EventQueue = PriorityQueue<Event>;
+#endif
+
 /**
  *  CollisionSystem class represents a collection of particles
  *  moving in the unit box, according to the laws of elastic collision.
@@ -32,16 +68,29 @@ public:
      */
     CollisionSystem(std::vector<Particle> particles);
 
+    /**
+     * Constructor to restart a simulation from a checkpoint, the simulation clock starts at
+     * the time of the checkpoint and the event queue is rebuilt by the first simulate
+     */
+    explicit CollisionSystem(Checkpoint checkpoint);
+
     // Disable copying
     CollisionSystem(const CollisionSystem&) = delete;
     CollisionSystem& operator=(const CollisionSystem&) = delete;
 
     /**
-     * Simulate the system of particles for the specified amount of simulationTime
-     * renderFrequenzy is the number of times the particles are rendered per time unit
+     * Simulate the system of particles until the simulation clock reaches simulationTime,
+     * starting from time() (0 for a new system)
+     * renderFrequenzy is the number of times the particles are rendered per time unit,
+     * no rendering events are scheduled if it is 0 (headless simulation)
      */
     void simulate(double simulationTime, double renderFrequenzy);
 
+    /**
+     * Simulation time of the particles, the time of the last event of simulate
+     */
+    double time() const { return time_; }
+
     /**
      * Returns the kinetic energy of the particles system
      */
@@ -52,18 +101,303 @@ public:
      */
     const std::vector<Particle>& particles() const;
 
-    // To be used by for rendering
+    /**
+     * Counters of a simulation, to see where it spends its time
+     * The times of the phases are only measured if timing is true
+     */
+    struct Statistics {
+        std::int64_t events = 0;         // valid events processed, of all types
+        std::int64_t invalidated = 0;    // invalidated events discarded (lazy scheduling)
+        std::int64_t predictions = 0;    // particles whose events were predicted
+        std::int64_t queueInserts = 0;   // events inserted in, or updated in, the queue
+        std::int64_t queueRemovals = 0;  // events removed by deleteMin (lazy scheduling)
+        std::int64_t compactions = 0;    // compactions of the queue (lazy scheduling)
+        std::int64_t compacted = 0;      // invalidated events removed by compactions
+        std::int64_t windows = 0;        // optimistic parallel windows (region scheduling)
+        std::int64_t undone = 0;         // events processed past the stop of a window, rolled back
+        std::int64_t criticalPath = 0;   // events of the busiest region of each window, and
+                                         // events processed alone between windows
+        std::size_t peakQueueSize = 0;   // largest number of events in the queue
+        double startTime = 0.0;          // simulation clock at the start of simulate
+        double simulatedTime = 0.0;      // simulation clock at the last event
+        double wallSeconds = 0.0;        // wall-clock time of simulate
+        double predictSeconds = 0.0;     // time spent predicting events
+        double queueSeconds = 0.0;       // time spent in queue operations
+        double moveSeconds = 0.0;        // time spent moving particles
+        bool timed = false;              // the phases were timed (timing)
+        bool compacting = false;         // lazy scheduling with compaction of the queue
+        bool windowed = false;           // region scheduling
+
+        /**
+         * Events processed per simulated time unit
+         */
+        double eventsPerTimeUnit() const {
+            const double duration = simulatedTime - startTime;
+            return duration > 0.0 ? events / duration : 0.0;
+        }
+
+        /**
+         * Upper bound of the speedup of region scheduling with one thread per region: the
+         * events kept or discarded over the events on the critical path, without the cost of
+         * synchronising the windows
+         */
+        double speedupBound() const {
+            return criticalPath > 0 ? static_cast<double>(events + invalidated) / criticalPath
+                                    : 0.0;
+        }
+
+        /**
+         * Return a multi-line report of the counters
+         * The times of the phases, the compactions and the windows are only reported when they
+         * were measured or used
+         */
+        std::string report() const;
+    };
+
+    /**
+     * Counters of the last call to simulate, or of the running simulation
+     */
+    const Statistics& statistics() const;
+
+    /**
+     * To measure the time spent in each phase of the event loop, which costs a few
+     * clock reads per event
+     */
+    bool timing = false;
+
+    /**
+     * Optional periodic report, called with the counters every reportInterval time units
+     * of the simulation
+     */
+    std::function<void(const Statistics&)> reportCallback;
+    double reportInterval = 1.0;
+
+    /**
+     * Optional periodic checkpoint, called every checkpointInterval time units of the
+     * simulation with a copy of the particles at the current time, for instance to hand it
+     * to a CheckpointWriter. The event loop is not otherwise affected
+     */
+    std::function<void(std::vector<Particle>, double)> checkpointCallback;
+    double checkpointInterval = 0.0;
+
+    /**
+     * Deterministic mode: the trajectories only depend on the initial particles and the
+     * broad phase and scheduling, not on rendering, the event queue or the number of threads
+     * Simultaneous events are always processed in the order of Event::operator<=>. In this
+     * mode renderCallback also gets a copy of the particles moved to the current time, as
+     * moving the particles themselves changes their round-off
+     */
+    bool deterministic = false;
+
+    /**
+     * Optional trace to compare runs, called at each multiple of traceInterval time units of
+     * the simulation with the time and the hash of the state of the particles (hash_particles)
+     */
+    std::function<void(double, std::uint64_t)> traceCallback;
+    double traceInterval = 0.0;
+
+    // To be used by for rendering, both are optional
     std::function<void(std::span<Particle>)> renderCallback;
     std::function<bool()> abortCallback;
 
+    /**
+     * How the pending events are kept in the event queue
+     *  - Lazy:    every predicted event is queued, events invalidated by an earlier
+     *             collision are discarded when they reach the front of the queue
+     *  - Indexed: the queue holds one entry per particle, its earliest event, which is
+     *             updated in place when the particle or its partner collides. A reverse index
+     *             finds the entries whose partner collided, in time proportional to their number
+     *  - Regions: lazy scheduling with one queue per region, a strip of columns of the cell
+     *             grid. The regions process their events in parallel, in windows that end at
+     *             the earliest event at a boundary between regions, which is then processed
+     *             alone. The events are the same as with Lazy. Needs the Grid broad phase,
+     *             otherwise it is Lazy
+     */
+    enum class Scheduling { Lazy, Indexed, Regions };
+    Scheduling scheduling = Scheduling::Lazy;
+
+    /**
+     * Number of regions of Scheduling::Regions, 0 for one per thread
+     * A region is at least 4 columns of the cell grid wide, so small systems get fewer regions
+     */
+    int regions = 0;
+
+    /**
+     * Prediction horizon of lazy scheduling, in time units of the simulation
+     * Only the events of a particle within the horizon from its prediction are queued. If an
+     * event was left out, the particle is predicted again when the horizon is reached, with a
+     * Horizon event. Far events are usually invalidated before they happen, so a horizon of a
+     * few times between collisions keeps most of them out of the queue. The default queues
+     * every event before the end of the simulation
+     */
+    double predictionHorizon = std::numeric_limits<double>::infinity();
+
+    /**
+     * Fraction of invalidated events in the queue of lazy scheduling above which they are all
+     * removed at once, in a pass linear in the size of the queue (EventQueue::removeIf)
+     * The events of a particle are counted as invalidated when it collides, so the size of the
+     * queue stays within a constant factor of the number of valid events. 1 never compacts
+     */
+    double compactionThreshold = 0.5;
+
+    /**
+     * Which particles a particle is tested against when its collisions are predicted
+     *  - AllPairs: all particles, O(n) per prediction
+     *  - Grid:     the particles in the neighbouring cells of a CellGrid, the grid adds
+     *              cell-crossing events to keep the neighbourhoods up to date
+     */
+    enum class BroadPhase { AllPairs, Grid };
+    BroadPhase broadPhase = BroadPhase::AllPairs;
+
+    /**
+     * Number of threads predicting events, the default is one per core
+     * The predicted events and their order do not depend on the number of threads
+     */
+    int threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+
 private:
+    // Scratch space of a thread predicting events
+    struct Worker {
+        std::vector<Event> events;  // predicted events
+        std::vector<double> times;  // collision times computed by store_
+        double dt = 0.0;            // time to the earliest collision found in a range
+        int other = Event::none;    // particle of that collision
+        bool truncated = false;     // an event was beyond the prediction horizon
+    };
+
     /**
-     * Update priority queue with all new events for particle
+     * Add all new events for particle i to events, to be inserted in the priority queue
      */
-    void predict(PriorityQueue<Event>& queue, Particle& particle, double currentTime,
+    void predict(std::vector<Event>& events, int i, double currentTime, double simulationTime,
+                 Worker& worker);
+
+    /**
+     * Add all new events for the particles in indices to events, in the order of indices
+     * The work is split between the threads by particles, or by candidates if there are few
+     * particles to predict
+     */
+    void predict(std::vector<Event>& events, std::span<const int> indices, double currentTime,
                  double simulationTime);
 
-    std::vector<Particle> particles_;  // the particles
+    // Add the events of particle i with the walls and the cell grid to events, and its Horizon
+    // event if truncated or if one of these events is beyond the prediction horizon
+    void predictWalls(std::vector<Event>& events, int i, double currentTime,
+                      double simulationTime, bool truncated);
+
+    /**
+     * Return the earliest event of particle i, possibly later than simulationTime
+     */
+    Event earliestEvent(int i, double currentTime, Worker& worker);
+
+    // Earliest event of particle i, among its collision with other in dt and its events with
+    // the walls and the cell grid
+    Event earliestEvent(int i, double currentTime, double dt, int other) const;
+
+    /**
+     * Update the entries of the particles in indices in the indexed queue with their earliest
+     * events, the work is split between the threads as for the lazy queue
+     */
+    void predict(IndexedPriorityQueue<Event>& queue, std::span<const int> indices,
+                 double currentTime, double simulationTime);
+
+    // Call f(j, dt) for every particle j that particle i may collide with, dt is the amount of
+    // time for them to collide
+    template <class Function>
+    void forCandidates(int i, double currentTime, std::vector<double>& times, Function f) const;
+
+    // Call f(j, dt) for the particles first <= j < last, using the vectorised ParticleStore
+    template <class Function>
+    void forCandidates(int i, double currentTime, int first, int last, std::vector<double>& times,
+                       Function f) const;
+
+    // Store the trajectory of particle i after its velocity changed
+    void updateTrajectory(int i) { store_.update(i, particles_[i]); }
+
+    // Count the queued events of particle i as particle a as invalidated, after its collision
+    void countInvalidated(int i) { invalidated_ += std::exchange(queuedA_[i], 0); }
+
+    // Move all particles to their positions at time
+    void moveAllTo(double time);
+
+    // Count an event at currentTime and call reportCallback if a report is due
+    void countEvent(double currentTime);
+
+    // Call reportCallback if a report is due at currentTime
+    void report(double currentTime);
+
+    // Wall-clock time since the start of simulate
+    double elapsedSeconds() const;
+
+    // Call checkpointCallback if a checkpoint is due, all events before currentTime are done
+    void checkpoint(double currentTime);
+
+    // Call traceCallback for each multiple of traceInterval up to time, all events before time
+    // are done
+    void trace(double time);
+
+    // Call renderCallback with the particles at currentTime
+    void render(double currentTime);
+
+    // A strip of columns of the grid in region scheduling, and the shared state of a window
+    struct Region;
+    struct Window;
+
+    // What a region does with an event in a window
+    enum class Access {
+        Process,  // the event only involves the region
+        Discard,  // the event is invalid
+        Stop      // the event may involve another region, the window ends at it
+    };
+
+    // Process event e, a collision, cell crossing or Horizon event, at its time, and add the new
+    // events to events. If region is not null, the event is processed in a window of region
+    // and its changes are logged so that they can be undone
+    void processEvent(const Event& e, std::vector<Event>& events, double simulationTime,
+                      Region* region);
+
+    // Event loop with lazy invalidation of events
+    void simulateLazy(double simulationTime, double renderFrequenzy);
+
+    // Event loop of region scheduling, the events are processed by the regions in parallel
+    void simulateRegions(double simulationTime, double renderFrequenzy);
+
+    // What region does with e, from the particles of the region and the others at the start
+    // of the window
+    Access access(const Event& e, const Region& region) const;
+
+    // Process the events of region before the end of window, until one of them is at a
+    // boundary
+    void simulateWindow(Region& region, Window& window);
+
+    // Undo the events of region after the earliest stop of window and queue the new events
+    void commitWindow(Region& region, const Window& window);
+
+    // Event loop with one indexed queue entry per particle
+    void simulateIndexed(double simulationTime, double renderFrequenzy);
+
+    std::vector<Particle> particles_;   // the particles
+    CellGrid grid_;                     // cells of the particles, if broadPhase is Grid
+    ParticleStore store_;               // trajectories of the particles, if broadPhase is AllPairs
+    std::unique_ptr<ThreadPool> pool_;  // threads predicting events
+    std::vector<Worker> workers_;       // scratch space of each thread in pool_
+    Statistics statistics_;             // counters of the last simulation
+    double time_ = 0.0;                 // simulation time of the particles
+    double nextReport_ = 0.0;           // simulation time of the next call to reportCallback
+    double nextCheckpoint_ = 0.0;       // simulation time of the next checkpoint
+    double nextTrace_ = 0.0;            // simulation time of the next call to traceCallback
+    std::vector<Particle> copies_;      // particles given to renderCallback, if deterministic
+    std::vector<Event> earliest_;       // earliest events of the particles predicted at once
+    std::vector<double> horizons_;      // time of the pending Horizon event of each particle
+    std::vector<int> queuedA_;          // queued events of each particle as a since its collision
+    std::int64_t invalidated_ = 0;      // queued events whose particle a collided since
+    std::vector<int> owner_;            // region of each particle (region scheduling)
+    std::vector<int> counts_;           // collision counts at the start of the window
+
+    // handles of the indexed queue whose event has particle b i, for each particle i
+    std::vector<std::vector<int>> dependents_;
+
+    // wall-clock time at the start of simulate
+    std::chrono::steady_clock::time_point start_;
 };
 
 }  // namespace particlesystem
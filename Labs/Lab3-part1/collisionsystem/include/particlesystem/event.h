@@ -2,82 +2,150 @@
 
 #include <iostream>
 #include <compare>
+#include <cstdint>
+#include <span>
+#include <cassert>
+#include <tuple>
 
 #include <particlesystem/particle.h>
 
 namespace particlesystem {
 
-class CollisionSystem;
-
 /**
  *  An event during a particle collision simulation. Each event contains
- *  the time at which it will occur and the particles a and b involved.
- *  There are 4 types of events:
- *    -  a and b both null:      rendering event
- *    -  a null, b not null:     collision with vertical wall
- *    -  a not null, b null:     collision with horizontal wall
- *    -  a and b both not null:  binary collision between a and b
+ *  the time at which it will occur, its type and the particles a and b involved,
+ *  given by their indices in the particles of the simulation.
+ *  There are 6 types of events:
+ *    -  Render:          rendering event, no particles involved
+ *    -  VerticalWall:    collision of a with a vertical wall
+ *    -  HorizontalWall:  collision of a with a horizontal wall
+ *    -  Collision:       binary collision between a and b
+ *    -  CellCrossing:    a crosses into another cell of the grid (CellGrid)
+ *    -  Horizon:         a is predicted again, its events beyond the prediction horizon
+ *                        (CollisionSystem::predictionHorizon) were left out
  *
+ *  Events are copied through every operation of the event queue, so they are packed
+ *  in 24 bytes: the type is stored in the highest bits of the index of a.
  */
 class Event {
 public:
+    enum class Type : std::uint32_t {
+        Render,
+        VerticalWall,
+        HorizontalWall,
+        Collision,
+        CellCrossing,
+        Horizon
+    };
+
+    static constexpr int none = -1;  // index of a particle not involved in the event
+
+    /**
+     * Constructor to create a new rendering event to occur at time t
+     */
+    explicit Event(double t = 0.0) : Event(t, Type::Render, {}) {}
+
     /**
-     * Constructor to create a new event to occur at time t involving two particles
+     * Constructor to create a new event of type to occur at time t involving particles a and b
+     * of particles, a and b are none if the event does not involve them
      */
-    explicit Event(double t = 0.0, Particle* ptrA = nullptr, Particle* ptrB = nullptr);
+    Event(double t, Type type, std::span<const Particle> particles, int a = none, int b = none);
 
     /*
      * Overloaded three-way comparison operator: chronological comparison using time
+     * Events at the same time are ordered by type, particles and collision counts, so that
+     * every event queue processes simultaneous events in the same order
      */
-    // std::strong_ordering operator<=>(const Event& e) const;
-    auto operator<=>(const Event& e) const { return time <=> e.time; }
+    std::partial_ordering operator<=>(const Event& e) const {
+        if (const auto order = time <=> e.time; order != 0) {
+            return order;
+        }
+        return std::tie(typeAndA, indexB, countA, countB) <=>
+               std::tie(e.typeAndA, e.indexB, e.countA, e.countB);
+    }
 
     /**
      * To check whether any collision occurred between when event was created and now
      */
-    bool isValid() const;
+    bool isValid(std::span<const Particle> particles) const;
+
+    /**
+     * To check whether particle a collided since the event was created, false if a is none
+     */
+    bool hasCollidedA(std::span<const Particle> particles) const {
+        const int a = particleA();
+        return a != none && particles[a].counter() != countA;
+    }
+
+    /**
+     * To check whether particle i, a or b of the event, collided since the event was created,
+     * given the collision count of i now
+     */
+    bool hasCollided(int i, int count) const {
+        return count != (i == particleA() ? countA : countB);
+    }
+
+    /**
+     * Time at which the event is scheduled to occur
+     */
+    double scheduledTime() const { return time; }
+
+    /**
+     * Type of the event
+     */
+    Type type() const { return static_cast<Type>(typeAndA >> index_bits); }
+
+    /**
+     * Index of particle a, or none
+     */
+    int particleA() const { return decode(typeAndA & index_mask); }
 
-    friend CollisionSystem;
+    /**
+     * Index of particle b, or none
+     */
+    int particleB() const { return decode(indexB); }
 
 private:
-    double time;          // time that event is scheduled to occur
-    Particle* particleA;  // particle involved in event, possibly null
-    Particle* particleB;  // particle involved in event, possibly null
-    int countA;           // collision count at event creation
-    int countB;           // collision count at event creation
+    static constexpr int index_bits = 29;  // the highest 3 bits of typeAndA hold the type
+    static constexpr std::uint32_t index_mask = (std::uint32_t{1} << index_bits) - 1;
+
+    // none is stored as index_mask, the largest index that fits
+    static std::uint32_t encode(int i) { return i == none ? index_mask : std::uint32_t(i); }
+    static int decode(std::uint32_t i) { return i == index_mask ? none : static_cast<int>(i); }
+
+    double time;             // time that event is scheduled to occur
+    std::uint32_t typeAndA;  // type of the event and index of particle a
+    std::uint32_t indexB;    // index of particle b
+    std::int32_t countA;     // collision count of a at event creation
+    std::int32_t countB;     // collision count of b at event creation
 };
 
+static_assert(sizeof(Event) == 24);
+
 /**
- * Constructor to create a new event to occur at time t involving two particles
+ * Constructor to create a new event of type to occur at time t involving particles a and b
+ * of particles, a and b are none if the event does not involve them
  */
-inline Event::Event(double t, Particle* ptrA, Particle* ptrB)
+inline Event::Event(double t, Type type, std::span<const Particle> particles, int a, int b)
     : time{t}
-    , particleA{ptrA}
-    , particleB{ptrB}
-    , countA{particleA != nullptr ? particleA->counter() : -1}
-    , countB{particleB != nullptr ? particleB->counter() : -1} {}
-
-/*
- * Overloaded three-way comparison operator: chronological comparison using time
- */
-//inline std::strong_ordering Event::operator<=>(const Event& e) const {
-//    if (time == e.time) {
-//        return std::strong_ordering::equivalent;
-//    }
-//    if (time < e.time) {
-//        return std::strong_ordering::less;
-//    }
-//    return std::strong_ordering::greater;
-//}
+    , typeAndA{static_cast<std::uint32_t>(type) << index_bits | encode(a)}
+    , indexB{encode(b)}
+    , countA{a != none ? particles[a].counter() : -1}
+    , countB{b != none ? particles[b].counter() : -1} {
+    assert(a == none || (a >= 0 && std::uint32_t(a) < index_mask));
+    assert(b == none || (b >= 0 && std::uint32_t(b) < index_mask));
+}
 
 /**
  * To check whether any collision occurred between when event was created and now
  */
-inline bool Event::isValid() const {
-    if (particleA != nullptr && particleA->counter() != countA) {
+inline bool Event::isValid(std::span<const Particle> particles) const {
+    const int a = particleA();
+    if (a != none && particles[a].counter() != countA) {
         return false;
     }
-    if (particleB != nullptr && particleB->counter() != countB) {
+    const int b = particleB();
+    if (b != none && particles[b].counter() != countB) {
         return false;
     }
     return true;
@@ -0,0 +1,312 @@
+#pragma once
+
+#include <vector>
+#include <cassert>
+#include <cstddef>
+#include <algorithm>
+#include <utility>
+
+/**
+ * A heap based priority queue of keys, where each key is attached to a handle in [0, capacity)
+ * Handles make the queue addressable: the key of a handle can be decreased, increased or
+ * erased in place, in logarithmic time
+ *
+ * The heap stores handles. Each node has D children, the children of the node at index i
+ * are stored at indices D*i+1, ..., D*i+D
+ */
+template <class Comparable, int D = 4>
+class IndexedPriorityQueue {
+    static_assert(D >= 2, "a heap node needs at least two children");
+
+public:
+    /**
+     * Constructor to create an empty queue for handles 0, ..., capacity-1
+     */
+    explicit IndexedPriorityQueue(int capacity);
+
+    // Disable copying
+    IndexedPriorityQueue(const IndexedPriorityQueue&) = delete;
+    IndexedPriorityQueue& operator=(const IndexedPriorityQueue&) = delete;
+
+    /**
+     * Make the queue empty
+     */
+    void makeEmpty();
+
+    /**
+     * Check is the queue is empty
+     * Return true if the queue is empty, false otherwise
+     */
+    bool isEmpty() const { return heap.empty(); }
+
+    /**
+     * Get the size of the queue, i.e. number of handles in the queue
+     */
+    size_t size() const { return heap.size(); }
+
+    /**
+     * Check whether handle h is in the queue
+     */
+    bool contains(int h) const;
+
+    /**
+     * Get the key of handle h, h must be in the queue
+     */
+    const Comparable& key(int h) const;
+
+    /**
+     * Get the handle with the smallest key in the queue
+     */
+    int findMin() const;
+
+    /**
+     * Remove the handle with the smallest key from the queue and return it
+     */
+    int deleteMin();
+
+    /**
+     * Add handle h with key x to the queue, h must not be in the queue
+     */
+    void insert(int h, Comparable x);
+
+    /**
+     * Replace the key of handle h by the smaller or equal key x
+     */
+    void decreaseKey(int h, Comparable x);
+
+    /**
+     * Replace the key of handle h by the larger or equal key x
+     */
+    void increaseKey(int h, Comparable x);
+
+    /**
+     * Set the key of handle h to x: insert h or decrease/increase its key as needed
+     */
+    void update(int h, Comparable x);
+
+    /**
+     * Remove handle h from the queue, h must be in the queue
+     */
+    void erase(int h);
+
+private:
+    static constexpr int none = -1;  // position of a handle not in the queue
+
+    std::vector<int> heap;         // heap of handles
+    std::vector<int> position;     // position[h]: index of handle h in heap, or none
+    std::vector<Comparable> keys;  // keys[h]: key of handle h
+
+    // Auxiliary member functions
+
+    /**
+     * Test whether heap is a min heap
+     */
+    bool isMinHeap() const;
+
+    // Place handle h at index i of the heap
+    void place(std::size_t i, int h);
+
+    // PercolateDown
+    void percolateDown(std::size_t i);
+
+    // PercolateUp
+    void percolateUp(std::size_t i);
+};
+
+/* *********************** Member functions implementation *********************** */
+
+/**
+ * Constructor to create an empty queue for handles 0, ..., capacity-1
+ */
+template <class Comparable, int D>
+IndexedPriorityQueue<Comparable, D>::IndexedPriorityQueue(int capacity)
+    : position(capacity, none), keys(capacity) {
+    heap.reserve(capacity);
+    assert(isEmpty());
+}
+
+/**
+ * Make the queue empty
+ */
+template <class Comparable, int D>
+void IndexedPriorityQueue<Comparable, D>::makeEmpty() {
+    for (int h : heap) {
+        position[h] = none;
+    }
+    heap.clear();
+}
+
+/**
+ * Check whether handle h is in the queue
+ */
+template <class Comparable, int D>
+bool IndexedPriorityQueue<Comparable, D>::contains(int h) const {
+    assert(h >= 0 && h < std::ssize(position));
+    return position[h] != none;
+}
+
+/**
+ * Get the key of handle h, h must be in the queue
+ */
+template <class Comparable, int D>
+const Comparable& IndexedPriorityQueue<Comparable, D>::key(int h) const {
+    assert(contains(h));
+    return keys[h];
+}
+
+/**
+ * Get the handle with the smallest key in the queue
+ */
+template <class Comparable, int D>
+int IndexedPriorityQueue<Comparable, D>::findMin() const {
+    assert(!isEmpty());
+    return heap[0];
+}
+
+/**
+ * Remove the handle with the smallest key from the queue and return it
+ */
+template <class Comparable, int D>
+int IndexedPriorityQueue<Comparable, D>::deleteMin() {
+    const int h = findMin();
+    erase(h);
+    return h;
+}
+
+/**
+ * Add handle h with key x to the queue, h must not be in the queue
+ */
+template <class Comparable, int D>
+void IndexedPriorityQueue<Comparable, D>::insert(int h, Comparable x) {
+    assert(!contains(h));
+    keys[h] = std::move(x);
+    heap.push_back(h);
+    position[h] = static_cast<int>(heap.size() - 1);
+    percolateUp(heap.size() - 1);
+#ifdef TEST_PRIORITY_QUEUE
+    assert(isMinHeap());
+#endif
+}
+
+/**
+ * Replace the key of handle h by the smaller or equal key x
+ */
+template <class Comparable, int D>
+void IndexedPriorityQueue<Comparable, D>::decreaseKey(int h, Comparable x) {
+    assert(contains(h) && !(keys[h] < x));
+    keys[h] = std::move(x);
+    percolateUp(position[h]);
+#ifdef TEST_PRIORITY_QUEUE
+    assert(isMinHeap());
+#endif
+}
+
+/**
+ * Replace the key of handle h by the larger or equal key x
+ */
+template <class Comparable, int D>
+void IndexedPriorityQueue<Comparable, D>::increaseKey(int h, Comparable x) {
+    assert(contains(h) && !(x < keys[h]));
+    keys[h] = std::move(x);
+    percolateDown(position[h]);
+#ifdef TEST_PRIORITY_QUEUE
+    assert(isMinHeap());
+#endif
+}
+
+/**
+ * Set the key of handle h to x: insert h or decrease/increase its key as needed
+ */
+template <class Comparable, int D>
+void IndexedPriorityQueue<Comparable, D>::update(int h, Comparable x) {
+    if (!contains(h)) {
+        insert(h, std::move(x));
+    } else if (x < keys[h]) {
+        decreaseKey(h, std::move(x));
+    } else {
+        increaseKey(h, std::move(x));
+    }
+}
+
+/**
+ * Remove handle h from the queue, h must be in the queue
+ */
+template <class Comparable, int D>
+void IndexedPriorityQueue<Comparable, D>::erase(int h) {
+    assert(contains(h));
+    const std::size_t i = position[h];
+    const int last = heap.back();
+    heap.pop_back();
+    position[h] = none;
+
+    if (last != h) {  // fill the hole at i with the last handle
+        place(i, last);
+        percolateUp(i);
+        percolateDown(position[last]);
+    }
+#ifdef TEST_PRIORITY_QUEUE
+    assert(isMinHeap());
+#endif
+}
+
+/* ******************* Private member functions ********************* */
+
+/**
+ * Test whether heap is a min heap
+ */
+template <class Comparable, int D>
+bool IndexedPriorityQueue<Comparable, D>::isMinHeap() const {
+    for (std::size_t i = 1; i < heap.size(); ++i) {
+        if (keys[heap[i]] < keys[heap[(i - 1) / D]]) return false;
+    }
+    return true;
+}
+
+/**
+ * Place handle h at index i of the heap
+ */
+template <class Comparable, int D>
+void IndexedPriorityQueue<Comparable, D>::place(std::size_t i, int h) {
+    heap[i] = h;
+    position[h] = static_cast<int>(i);
+}
+
+/**
+ * Move the handle at index i down until its key is not larger than the keys of its children
+ */
+template <class Comparable, int D>
+void IndexedPriorityQueue<Comparable, D>::percolateDown(std::size_t i) {
+    const int h = heap[i];
+    const std::size_t n = heap.size();
+
+    for (std::size_t c = D * i + 1; c < n; c = D * i + 1) {
+        // child with the smallest key among the (up to) D siblings c, ..., c+D-1
+        std::size_t smallest = c;
+        const std::size_t last = std::min(c + D, n);
+        for (std::size_t k = c + 1; k < last; ++k) {
+            if (keys[heap[k]] < keys[heap[smallest]]) smallest = k;
+        }
+
+        if (keys[heap[smallest]] < keys[h]) {
+            place(i, heap[smallest]);
+            i = smallest;
+        } else {
+            break;
+        }
+    }
+    place(i, h);
+}
+
+/**
+ * Move the handle at index i up until its key is not smaller than the key of its parent
+ */
+template <class Comparable, int D>
+void IndexedPriorityQueue<Comparable, D>::percolateUp(std::size_t i) {
+    const int h = heap[i];
+
+    while (i > 0 && keys[h] < keys[heap[(i - 1) / D]]) {
+        place(i, heap[(i - 1) / D]);
+        i = (i - 1) / D;
+    }
+    place(i, h);
+}
@@ -0,0 +1,245 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <cassert>
+#include <cstddef>
+#include <span>
+#include <utility>
+
+/**
+ * A priority queue implemented as a pairing heap, where the root is the smallest element
+ * insert is O(1) and deleteMin is O(log n) amortized
+ *
+ * Nodes are stored in a pool and recycled, so that a steady state of inserts and deleteMins
+ * does not allocate memory
+ */
+template <class Comparable>
+class PairingHeap {
+public:
+    /**
+     * Constructor to create an empty queue
+     * initCapacity is accepted for compatibility with PriorityQueue
+     */
+    explicit PairingHeap([[maybe_unused]] int initCapacity = 100) {}
+
+    // Disable copying
+    PairingHeap(const PairingHeap&) = delete;
+    PairingHeap& operator=(const PairingHeap&) = delete;
+
+    /**
+     * Make the queue empty
+     */
+    void makeEmpty();
+
+    /**
+     * Check is the queue is empty
+     * Return true if the queue is empty, false otherwise
+     */
+    bool isEmpty() const { return root == nullptr; }
+
+    /**
+     * Get the size of the queue, i.e. number of elements in the queue
+     */
+    size_t size() const { return count; }
+
+    /**
+     * Get the smallest element in the queue
+     */
+    Comparable findMin() const {
+        assert(!isEmpty());
+        return root->element;
+    }
+
+    /**
+     * Remove and return the smallest element in the queue
+     */
+    Comparable deleteMin();
+
+    /**
+     * Add a new element x to the queue
+     */
+    void insert(const Comparable& x) { emplace(x); }
+
+    /**
+     * Add a new element x to the queue, moving it into the queue
+     */
+    void insert(Comparable&& x) { emplace(std::move(x)); }
+
+    /**
+     * Add a new element constructed in place from args to the queue
+     */
+    template <class... Args>
+    void emplace(Args&&... args);
+
+    /**
+     * Add all elements of batch to the queue
+     */
+    void insertBatch(std::span<const Comparable> batch) {
+        for (const Comparable& x : batch) {
+            emplace(x);
+        }
+    }
+
+    /**
+     * Remove all elements x for which pred(x) is true
+     * pred is called once for each element. The remaining nodes are combined into a new heap
+     * by one two-pass pairing, in linear time. Return the number of elements removed
+     */
+    template <class Predicate>
+    std::size_t removeIf(Predicate pred);
+
+private:
+    struct Node {
+        Comparable element;
+        Node* child = nullptr;    // leftmost child
+        Node* sibling = nullptr;  // next sibling to the right
+    };
+
+    Node* root = nullptr;
+    size_t count = 0;
+
+    std::deque<Node> pool;        // storage of all nodes, addresses are stable
+    std::vector<Node*> freeList;  // nodes in pool that are not in the heap
+    std::vector<Node*> siblings;  // scratch space for deleteMin
+
+    // Link the roots a and b, the larger root becomes the leftmost child of the smaller one
+    static Node* link(Node* a, Node* b);
+
+    // Combine the list of siblings starting at first into one tree: two-pass pairing
+    Node* combineSiblings(Node* first);
+};
+
+/* *********************** Member functions implementation *********************** */
+
+/**
+ * Make the queue empty
+ */
+template <class Comparable>
+void PairingHeap<Comparable>::makeEmpty() {
+    root = nullptr;
+    count = 0;
+    freeList.clear();
+    for (Node& node : pool) {
+        freeList.push_back(&node);
+    }
+}
+
+/**
+ * Remove and return the smallest element in the queue
+ */
+template <class Comparable>
+Comparable PairingHeap<Comparable>::deleteMin() {
+    assert(!isEmpty());
+
+    Node* oldRoot = root;
+    Comparable minElement = std::move(oldRoot->element);
+
+    root = combineSiblings(oldRoot->child);
+    freeList.push_back(oldRoot);
+    --count;
+
+    return minElement;
+}
+
+/**
+ * Add a new element constructed in place from args to the queue
+ */
+template <class Comparable>
+template <class... Args>
+void PairingHeap<Comparable>::emplace(Args&&... args) {
+    Node* node = nullptr;
+    if (freeList.empty()) {
+        node = &pool.emplace_back(Node{Comparable(std::forward<Args>(args)...)});
+    } else {
+        node = freeList.back();
+        freeList.pop_back();
+        *node = Node{Comparable(std::forward<Args>(args)...)};
+    }
+
+    root = (root == nullptr) ? node : link(root, node);
+    ++count;
+}
+
+/**
+ * Remove all elements x for which pred(x) is true
+ * Every node of the heap is detached, the nodes kept become a list of siblings
+ */
+template <class Comparable>
+template <class Predicate>
+std::size_t PairingHeap<Comparable>::removeIf(Predicate pred) {
+    std::vector<Node*> stack;
+    if (root != nullptr) {
+        stack.push_back(root);
+    }
+
+    Node* kept = nullptr;  // first of the siblings kept
+    std::size_t removed = 0;
+    while (!stack.empty()) {
+        Node* node = stack.back();
+        stack.pop_back();
+        if (node->child != nullptr) stack.push_back(node->child);
+        if (node->sibling != nullptr) stack.push_back(node->sibling);
+
+        node->child = nullptr;
+        if (pred(std::as_const(node->element))) {
+            node->sibling = nullptr;
+            freeList.push_back(node);
+            ++removed;
+        } else {
+            node->sibling = kept;
+            kept = node;
+        }
+    }
+
+    root = combineSiblings(kept);
+    count -= removed;
+    return removed;
+}
+
+/* ******************* Private member functions ********************* */
+
+/**
+ * Link the roots a and b, the larger root becomes the leftmost child of the smaller one
+ */
+template <class Comparable>
+auto PairingHeap<Comparable>::link(Node* a, Node* b) -> Node* {
+    if (b->element < a->element) {
+        std::swap(a, b);
+    }
+    b->sibling = a->child;
+    a->child = b;
+    a->sibling = nullptr;
+    return a;
+}
+
+/**
+ * Combine the list of siblings starting at first into one tree
+ * First pass links the siblings pairwise from left to right,
+ * second pass links the resulting trees from right to left
+ */
+template <class Comparable>
+auto PairingHeap<Comparable>::combineSiblings(Node* first) -> Node* {
+    if (first == nullptr) {
+        return nullptr;
+    }
+
+    siblings.clear();
+    while (first != nullptr) {
+        Node* a = first;
+        Node* b = a->sibling;
+        if (b == nullptr) {
+            a->sibling = nullptr;
+            siblings.push_back(a);
+            break;
+        }
+        first = b->sibling;
+        siblings.push_back(link(a, b));
+    }
+
+    Node* tree = siblings.back();
+    for (std::size_t i = siblings.size() - 1; i-- > 0;) {
+        tree = link(siblings[i], tree);
+    }
+    return tree;
+}
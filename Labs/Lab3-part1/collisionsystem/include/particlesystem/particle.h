@@ -29,6 +29,16 @@ struct Particle {
      */
     void move(double dt) { r += v * dt; }
 
+    /**
+     * Move this particle in a straight line to its position at the specified time
+     * A particle already at time is not written to
+     */
+    void moveTo(double t) {
+        if (t == time) return;
+        move(t - time);
+        time = t;
+    }
+
     /**
      * Returns the number of collisions involving this particle with
      * vertical walls, horizontal walls, or other particles.
@@ -93,6 +103,7 @@ struct Particle {
     double mass = 0.01;             // mass
     Color color = {1.0, 1.0, 1.0};  // color
     int count = 0;                  // number of collisions so far
+    double time = 0.0;              // simulation time at which the particle is at position r
 };
 
 /**
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <vector>
+#include <span>
+
+#include <particlesystem/particle.h>
+
+namespace particlesystem {
+
+/**
+ * The trajectories of the particles stored as a structure of arrays, for the vectorised
+ * prediction of collision times
+ *
+ * Entry i holds the trajectory of particle i: its position at time t, its velocity and radius.
+ * timesToHit moves the particles along their trajectories while computing, so an entry only
+ * needs to be updated when the velocity of the particle changes.
+ *
+ * If the library is compiled with AVX2 (CMake option ENABLE_AVX2), timesToHit handles four
+ * particles per instruction. The results are the same as those of Particle::timeToHit, except
+ * for the last bit if the compiler fuses multiplications and additions in Particle::timeToHit.
+ */
+class ParticleStore {
+public:
+    /**
+     * Replace the entries by the trajectories of particles
+     */
+    void assign(std::span<const Particle> particles);
+
+    /**
+     * Set the trajectory of particle i to the trajectory of p
+     */
+    void update(int i, const Particle& p);
+
+    /**
+     * Number of entries
+     */
+    int size() const { return static_cast<int>(rx.size()); }
+
+    /**
+     * Compute out[j] = particle.timeToHit(that), for every entry j, where that is particle j
+     * moved to time. particle must be at its position at time, and out must have size() elements
+     * The entry of particle itself gives std::numeric_limits<double>::infinity()
+     */
+    void timesToHit(const Particle& particle, double time, std::span<double> out) const {
+        timesToHit(particle, time, 0, size(), out);
+    }
+
+    /**
+     * Compute out[j] as above for the entries first <= j < last only
+     */
+    void timesToHit(const Particle& particle, double time, int first, int last,
+                    std::span<double> out) const;
+
+private:
+    std::vector<double> rx, ry;  // position at time t
+    std::vector<double> vx, vy;  // velocity
+    std::vector<double> radius;
+    std::vector<double> t;
+};
+
+}  // namespace particlesystem
@@ -3,19 +3,29 @@
 #include <iostream>
 #include <vector>
 #include <algorithm>
+#include <functional>
+#include <iterator>
 #include <cassert>
+#include <cstddef>
+#include <span>
+#include <utility>
 
 /**
  * A priority queue implemented as a decreasingly sorted vector
  * the smallest element is at the end of the vector
+ *
+ * findMin and deleteMin are O(1). insert finds the position of the new element by binary search
+ * and shifts the smaller elements one step, O(n) in the worst case but cheap when new elements
+ * are among the smallest, as new events in the simulation are. insertBatch sorts the batch and
+ * merges it with the queue in linear time.
  */
 template <class Comparable>
-class PriorityQueue {
+class SortedVectorQueue {
 public:
     /**
      * Constructor to create a queue with the given capacity
      */
-    explicit PriorityQueue(int initCapacity = 100) {
+    explicit SortedVectorQueue(int initCapacity = 100) {
         pq.reserve(initCapacity);
         makeEmpty();
         assert(isEmpty());
@@ -24,11 +34,13 @@ public:
     /**
      * Constructor to initialize a priority queue based on a given vector V
      */
-    explicit PriorityQueue(const std::vector<Comparable>& V) : pq{V} { heapify(); }
+    explicit SortedVectorQueue(const std::vector<Comparable>& V) : pq{V} {
+        std::sort(pq.begin(), pq.end(), std::greater<Comparable>());
+    }
 
     // Disable copying
-    PriorityQueue(const PriorityQueue&) = delete;
-    PriorityQueue& operator=(const PriorityQueue&) = delete;
+    SortedVectorQueue(const SortedVectorQueue&) = delete;
+    SortedVectorQueue& operator=(const SortedVectorQueue&) = delete;
 
     /**
      * Make the queue empty
@@ -59,7 +71,7 @@ public:
      */
     Comparable deleteMin() {
         assert(!isEmpty());
-        Comparable x = pq.back();
+        Comparable x = std::move(pq.back());
         pq.pop_back();
         return x;
     }
@@ -67,28 +79,58 @@ public:
     /**
      * Add a new element x to the queue
      */
-    void insert(const Comparable& x) {
-        pq.push_back(x);
-        heapify();
-    }
+    void insert(const Comparable& x) { emplace(x); }
 
-private:
-    std::vector<Comparable> pq;
+    /**
+     * Add a new element x to the queue, moving it into the queue
+     */
+    void insert(Comparable&& x) { emplace(std::move(x)); }
 
-    // Auxiliary member functions
+    /**
+     * Add a new element constructed in place from args to the queue
+     * x is placed after the elements that are not smaller, i.e. before all smaller elements
+     */
+    template <class... Args>
+    void emplace(Args&&... args) {
+        Comparable x(std::forward<Args>(args)...);
+        const auto pos = std::upper_bound(pq.begin(), pq.end(), x, std::greater<Comparable>());
+        pq.insert(pos, std::move(x));
+#ifdef TEST_PRIORITY_QUEUE
+        assert(isSorted());
+#endif
+    }
 
     /**
-     * Restore the heap property
+     * Add all elements of batch to the queue
+     * The batch is sorted and merged with the queue
      */
-    void heapify() {
-        // sort decreasingly
-        std::sort(pq.begin(), pq.end(), std::greater<Comparable>());
+    void insertBatch(std::span<const Comparable> batch) {
+        const auto middle = pq.insert(pq.end(), batch.begin(), batch.end());
+        std::sort(middle, pq.end(), std::greater<Comparable>());
+        std::inplace_merge(pq.begin(), middle, pq.end(), std::greater<Comparable>());
+#ifdef TEST_PRIORITY_QUEUE
+        assert(isSorted());
+#endif
+    }
+
+    /**
+     * Remove all elements x for which pred(x) is true, the others keep their order
+     * pred is called once for each element. Return the number of elements removed
+     */
+    template <class Predicate>
+    std::size_t removeIf(Predicate pred) {
+        return static_cast<std::size_t>(std::erase_if(pq, pred));
     }
 
+private:
+    std::vector<Comparable> pq;
+
+    // Auxiliary member functions
+
     /**
-     * Test whether pq is a min heap
+     * Test whether pq is sorted decreasingly
      */
-    bool isMinHeap() const {
+    bool isSorted() const {
         return std::is_sorted(pq.begin(), pq.end(), std::greater<Comparable>());
     }
 };
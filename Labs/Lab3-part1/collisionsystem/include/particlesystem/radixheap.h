@@ -0,0 +1,252 @@
+#pragma once
+
+#include <vector>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <span>
+#include <cstdint>
+#include <algorithm>
+#include <type_traits>
+#include <utility>
+
+/**
+ * Key of an element in a RadixHeap: the time at which it is scheduled
+ * Arithmetic types are their own key
+ */
+struct ScheduledTime {
+    template <class T>
+    double operator()(const T& x) const {
+        if constexpr (std::is_arithmetic_v<T>) {
+            return static_cast<double>(x);
+        } else {
+            return x.scheduledTime();
+        }
+    }
+};
+
+/**
+ * A monotone priority queue implemented as a radix heap
+ *
+ * Monotone: an inserted element must not be smaller than the last element removed,
+ * which holds for event times in the simulation. Elements with a smaller key are treated
+ * as if their key was equal to the key of the last element removed.
+ *
+ * The key of an element, a non-negative double, is mapped to the integer with the same bit
+ * pattern, which preserves the order. Bucket i holds the elements whose key first differs from
+ * the last removed key in bit i-1, so every element moves to a lower bucket at most 64 times:
+ * insert is O(1) and deleteMin is O(log C) amortized, C being the key range.
+ */
+template <class Comparable, class KeyOf = ScheduledTime>
+class RadixHeap {
+public:
+    /**
+     * Constructor to create an empty queue
+     * initCapacity is accepted for compatibility with PriorityQueue
+     */
+    explicit RadixHeap([[maybe_unused]] int initCapacity = 100) {}
+
+    // Disable copying
+    RadixHeap(const RadixHeap&) = delete;
+    RadixHeap& operator=(const RadixHeap&) = delete;
+
+    /**
+     * Make the queue empty
+     */
+    void makeEmpty();
+
+    /**
+     * Check is the queue is empty
+     * Return true if the queue is empty, false otherwise
+     */
+    bool isEmpty() const { return count == 0; }
+
+    /**
+     * Get the size of the queue, i.e. number of elements in the queue
+     */
+    size_t size() const { return count; }
+
+    /**
+     * Get the smallest element in the queue
+     */
+    Comparable findMin();
+
+    /**
+     * Remove and return the smallest element in the queue
+     */
+    Comparable deleteMin();
+
+    /**
+     * Add a new element x to the queue
+     */
+    void insert(const Comparable& x) { emplace(x); }
+
+    /**
+     * Add a new element x to the queue, moving it into the queue
+     */
+    void insert(Comparable&& x) { emplace(std::move(x)); }
+
+    /**
+     * Add a new element constructed in place from args to the queue
+     */
+    template <class... Args>
+    void emplace(Args&&... args);
+
+    /**
+     * Add all elements of batch to the queue
+     */
+    void insertBatch(std::span<const Comparable> batch) {
+        for (const Comparable& x : batch) {
+            emplace(x);
+        }
+    }
+
+    /**
+     * Remove all elements x for which pred(x) is true
+     * pred is called once for each element. Return the number of elements removed
+     */
+    template <class Predicate>
+    std::size_t removeIf(Predicate pred);
+
+private:
+    struct Item {
+        std::uint64_t key;
+        Comparable element;
+    };
+
+    static constexpr int n_buckets = 65;
+
+    std::array<std::vector<Item>, n_buckets> buckets;
+    std::uint64_t last = 0;  // key of the last element removed
+    size_t count = 0;
+
+    // Order preserving integer key of a non-negative time
+    static std::uint64_t encode(double time) {
+        return time > 0.0 ? std::bit_cast<std::uint64_t>(time) : 0;
+    }
+
+    // Bucket of an element with the given key: 0 if key == last, else 1 + highest differing bit
+    std::size_t bucketOf(std::uint64_t key) const {
+        return key == last ? 0 : 64 - std::countl_zero(key ^ last);
+    }
+
+    // Make sure that bucket 0 holds the smallest elements, the smallest of them at its back
+    void pull();
+
+    // Move the elements of the first non-empty bucket to lower buckets
+    void redistribute();
+};
+
+/* *********************** Member functions implementation *********************** */
+
+/**
+ * Make the queue empty
+ */
+template <class Comparable, class KeyOf>
+void RadixHeap<Comparable, KeyOf>::makeEmpty() {
+    for (auto& bucket : buckets) {
+        bucket.clear();
+    }
+    last = 0;
+    count = 0;
+}
+
+/**
+ * Get the smallest element in the queue
+ */
+template <class Comparable, class KeyOf>
+Comparable RadixHeap<Comparable, KeyOf>::findMin() {
+    assert(!isEmpty());
+    pull();
+    return buckets[0].back().element;
+}
+
+/**
+ * Remove and return the smallest element in the queue
+ */
+template <class Comparable, class KeyOf>
+Comparable RadixHeap<Comparable, KeyOf>::deleteMin() {
+    assert(!isEmpty());
+    pull();
+
+    Comparable minElement = std::move(buckets[0].back().element);
+    buckets[0].pop_back();
+    --count;
+
+    return minElement;
+}
+
+/**
+ * Add a new element constructed in place from args to the queue
+ */
+template <class Comparable, class KeyOf>
+template <class... Args>
+void RadixHeap<Comparable, KeyOf>::emplace(Args&&... args) {
+    Comparable x(std::forward<Args>(args)...);
+    const std::uint64_t key = std::max(encode(KeyOf{}(x)), last);
+    buckets[bucketOf(key)].push_back(Item{key, std::move(x)});
+    ++count;
+}
+
+/**
+ * Remove all elements x for which pred(x) is true
+ * The keys of the other elements do not change, so they stay in their buckets
+ */
+template <class Comparable, class KeyOf>
+template <class Predicate>
+std::size_t RadixHeap<Comparable, KeyOf>::removeIf(Predicate pred) {
+    std::size_t removed = 0;
+    for (auto& bucket : buckets) {
+        removed += std::erase_if(bucket, [&](const Item& item) { return pred(item.element); });
+    }
+    count -= removed;
+    return removed;
+}
+
+/* ******************* Private member functions ********************* */
+
+/**
+ * Make sure that bucket 0 holds the smallest elements, with the smallest of them by operator<
+ * at its back, so that elements with equal keys leave in a fixed order
+ * If bucket 0 is empty, the smallest key of the first non-empty bucket becomes last
+ * and the elements of that bucket are redistributed to lower buckets
+ */
+template <class Comparable, class KeyOf>
+void RadixHeap<Comparable, KeyOf>::pull() {
+    if (buckets[0].empty()) {
+        redistribute();
+    }
+
+    // bucket 0 usually holds a single element
+    auto& bucket = buckets[0];
+    if (bucket.size() > 1) {
+        const auto smallest =
+            std::min_element(bucket.begin(), bucket.end(),
+                             [](const Item& x, const Item& y) { return x.element < y.element; });
+        std::iter_swap(smallest, bucket.end() - 1);
+    }
+}
+
+/**
+ * Redistribute the elements of the first non-empty bucket to lower buckets, after the
+ * smallest of their keys becomes last
+ */
+template <class Comparable, class KeyOf>
+void RadixHeap<Comparable, KeyOf>::redistribute() {
+    std::size_t i = 1;
+    while (buckets[i].empty()) {
+        ++i;
+        assert(i < n_buckets);
+    }
+
+    last = buckets[i][0].key;
+    for (const Item& item : buckets[i]) {
+        last = std::min(last, item.key);
+    }
+
+    for (Item& item : buckets[i]) {
+        buckets[bucketOf(item.key)].push_back(std::move(item));
+    }
+    buckets[i].clear();
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include <particlesystem/particle.h>
+
+namespace particlesystem {
+
+/**
+ * Random configuration of n particles of equal radius and mass, placed uniformly in the unit
+ * box without overlaps, for scaling benchmarks of CollisionSystem
+ * The radius is chosen so that the particles cover the given fraction of the box (below 0.5)
+ * and the velocity components are normally distributed with standard deviation speed
+ * Return an empty vector if the particles cannot be placed
+ */
+std::vector<Particle> random_particles(long long n, double fraction, double speed, double mass,
+                                       std::uint32_t seed);
+
+}  // namespace particlesystem
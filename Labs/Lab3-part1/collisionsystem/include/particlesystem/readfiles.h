@@ -0,0 +1,23 @@
+#pragma once
+
+#include <vector>
+#include <filesystem>
+#include <span>
+
+#include <particlesystem/particle.h>
+
+namespace particlesystem {
+
+/**
+ * Read particles for the simulation from file
+ * Return an empty vector if the file cannot be opened or is not a particles file
+ */
+std::vector<Particle> read_particles(const std::filesystem::path& file);
+
+/**
+ * Write particles to file, in the format read by read_particles
+ * Return false if the file cannot be written
+ */
+bool write_particles(const std::filesystem::path& file, std::span<const Particle> particles);
+
+}  // namespace particlesystem
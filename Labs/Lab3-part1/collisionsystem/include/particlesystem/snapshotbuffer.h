@@ -0,0 +1,51 @@
+#pragma once
+
+#include <vector>
+#include <span>
+#include <mutex>
+
+#include <particlesystem/particle.h>
+
+namespace particlesystem {
+
+/**
+ * Triple buffer handing snapshots of the particles from the simulation thread to the
+ * rendering thread
+ *
+ * The simulation publishes a copy of the particles at each rendering event and the renderer
+ * acquires the latest published snapshot when it starts a frame. Each side owns one buffer and
+ * the third holds the latest snapshot, so the two sides only swap indices under the lock:
+ * neither of them ever waits for the other to copy or draw. Snapshots published faster than
+ * they are drawn are skipped.
+ */
+class SnapshotBuffer {
+public:
+    /**
+     * Copy particles to a new snapshot and make it the latest one
+     * To be called by the simulation thread only
+     */
+    void publish(std::span<const Particle> particles);
+
+    /**
+     * Make the latest published snapshot the front snapshot
+     * Return false if no snapshot was published since the last call
+     * To be called by the rendering thread only
+     */
+    bool acquire();
+
+    /**
+     * The front snapshot, valid until the next call to acquire
+     * To be called by the rendering thread only
+     */
+    std::span<Particle> front() { return buffers[frontIndex]; }
+
+private:
+    std::vector<Particle> buffers[3];
+    int backIndex = 0;   // buffer written by publish
+    int readyIndex = 1;  // latest published snapshot
+    int frontIndex = 2;  // buffer read by the renderer
+    bool fresh = false;  // the ready buffer was published after the last acquire
+    std::mutex mutex;    // protects the swaps of readyIndex and fresh
+};
+
+}  // namespace particlesystem
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <span>
+#include <cstdint>
+
+#include <particlesystem/particle.h>
+
+namespace particlesystem {
+
+/**
+ * Hash of the state of particles at time: the bits of their positions at time, their
+ * velocities and their collision counters, in the order of the particles
+ * Particles that are not at time are moved on the fly, as Particle::moveTo would move them,
+ * so that the particles are not changed
+ *
+ * Two runs with equal hashes at the same times have, with overwhelming probability, the same
+ * trajectories bit for bit.
+ */
+std::uint64_t hash_particles(std::span<const Particle> particles, double time);
+
+}  // namespace particlesystem
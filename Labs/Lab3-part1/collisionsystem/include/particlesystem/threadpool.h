@@ -0,0 +1,62 @@
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <cstdint>
+#include <utility>
+
+namespace particlesystem {
+
+/**
+ * A fixed set of threads running parallel loops
+ *
+ * parallelFor splits [0, n) in one range of consecutive indices per thread, and the calling
+ * thread takes the first range. Results written per thread and merged in thread order are
+ * therefore in the same order as the results of a sequential loop.
+ */
+class ThreadPool {
+public:
+    /**
+     * Constructor to create a pool with the given number of threads, including the calling thread
+     */
+    explicit ThreadPool(int threads);
+
+    ~ThreadPool();
+
+    // Disable copying
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * Number of threads, including the calling thread
+     */
+    int size() const { return static_cast<int>(workers.size()) + 1; }
+
+    /**
+     * Call f(t, first, last) on thread t for the t:th range [first, last) of [0, n)
+     * and wait until all calls have returned
+     */
+    void parallelFor(int n, const std::function<void(int, int, int)>& f);
+
+private:
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;      // a loop was started, or the pool is stopping
+    std::condition_variable finished;  // a worker finished its range
+    const std::function<void(int, int, int)>* task = nullptr;
+    int count = 0;                 // n of the current loop
+    std::uint64_t generation = 0;  // number of loops started
+    int running = 0;               // workers that have not finished the current loop
+    bool stop = false;
+
+    // Range of thread t in [0, n)
+    std::pair<int, int> range(int t, int n) const;
+
+    // Loop of worker thread t
+    void work(int t);
+};
+
+}  // namespace particlesystem
@@ -0,0 +1,190 @@
+#include <vector>
+#include <utility>
+#include <string>
+#include <random>
+#include <chrono>
+#include <filesystem>
+#include <algorithm>
+
+#include <particlesystem/collisionsystem.h>
+#include <particlesystem/readfiles.h>
+#include <particlesystem/priorityqueue.h>
+#include <particlesystem/priorityqueue-vector.h>
+#include <particlesystem/pairingheap.h>
+#include <particlesystem/radixheap.h>
+#include <particlesystem/calendarqueue.h>
+
+#include <fmt/format.h>
+
+using namespace particlesystem;
+
+const std::filesystem::path data_dir{DATA_DIR};
+
+namespace {
+
+/**
+ * Hold model: the queue holds n events and each step removes the earliest event
+ * and schedules a new one a random time after it, as the simulation does
+ * Return the average time in ns of one deleteMin + insert pair
+ */
+template <class Queue>
+double holdModel(int n, int steps) {
+    std::mt19937 gen{4};
+    std::exponential_distribution<double> dist{1.0};
+
+    std::vector<double> delays(steps);
+    for (double& delay : delays) {
+        delay = dist(gen);
+    }
+
+    std::vector<Event> events;
+    events.reserve(n);
+    for (int i = 0; i < n; ++i) {
+        events.emplace_back(dist(gen));
+    }
+
+    Queue queue(n);
+    queue.insertBatch(events);
+
+    const auto start = std::chrono::steady_clock::now();
+    for (double delay : delays) {
+        const Event e = queue.deleteMin();
+        queue.emplace(e.scheduledTime() + delay);
+    }
+    const auto stop = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double, std::nano>(stop - start).count() / steps;
+}
+
+void benchmarkQueues() {
+    fmt::print("Hold model, ns per deleteMin + insert\n");
+    fmt::print("{:>10} {:>10} {:>10} {:>10} {:>10} {:>10} {:>10} {:>10}\n", "size", "vector",
+               "heap D=2", "heap D=4", "heap D=8", "pairing", "radix", "calendar");
+
+    constexpr int steps = 1'000'000;
+    for (int n : {1'000, 100'000, 1'000'000, 4'000'000}) {
+        // an insert in the sorted vector shifts O(n) elements, fewer steps keep the run short
+        const int vectorSteps = std::min(steps, 1'000'000'000 / n);
+
+        fmt::print("{:>10} {:>10.1f} {:>10.1f} {:>10.1f} {:>10.1f} {:>10.1f} {:>10.1f} {:>10.1f}\n",
+                   n, holdModel<SortedVectorQueue<Event>>(n, vectorSteps),
+                   holdModel<PriorityQueue<Event, 2>>(n, steps),
+                   holdModel<PriorityQueue<Event, 4>>(n, steps),
+                   holdModel<PriorityQueue<Event, 8>>(n, steps),
+                   holdModel<PairingHeap<Event>>(n, steps), holdModel<RadixHeap<Event>>(n, steps),
+                   holdModel<CalendarQueue<Event>>(n, steps));
+    }
+}
+
+/**
+ * Seed a queue with n events, by n inserts or by one insertBatch
+ * The events come in random order, or in decreasing order which is the worst case for inserts
+ * Return the time in ms
+ */
+template <class Queue>
+double seed(int n, bool decreasing, bool batch) {
+    std::mt19937 gen{4};
+    std::exponential_distribution<double> dist{1.0};
+
+    std::vector<Event> events;
+    events.reserve(n);
+    for (int i = 0; i < n; ++i) {
+        events.emplace_back(dist(gen));
+    }
+    if (decreasing) {
+        std::ranges::sort(events, [](const Event& a, const Event& b) { return b < a; });
+    }
+
+    Queue queue(n);
+    const auto start = std::chrono::steady_clock::now();
+    if (batch) {
+        queue.insertBatch(events);
+    } else {
+        for (const Event& e : events) {
+            queue.insert(e);
+        }
+    }
+    const auto stop = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double, std::milli>(stop - start).count();
+}
+
+void benchmarkSeeding() {
+    fmt::print("\nSeeding heap D={}, ms\n", PRIORITY_QUEUE_ARITY);
+    fmt::print("{:>10} {:>24} {:>24}\n", "", "random order", "decreasing order");
+    fmt::print("{:>10} {:>10} {:>13} {:>10} {:>13}\n", "size", "inserts", "insertBatch",
+               "inserts", "insertBatch");
+
+    for (int n : {1'000, 100'000, 1'000'000, 4'000'000}) {
+        fmt::print("{:>10} {:>10.2f} {:>13.2f} {:>10.2f} {:>13.2f}\n", n,
+                   seed<PriorityQueue<Event>>(n, false, false),
+                   seed<PriorityQueue<Event>>(n, false, true),
+                   seed<PriorityQueue<Event>>(n, true, false),
+                   seed<PriorityQueue<Event>>(n, true, true));
+    }
+}
+
+void benchmarkSimulation() {
+    struct Scenario {
+        std::string file;
+        double simulationTime;
+    };
+    const std::vector<Scenario> scenarios{{"billiards10.txt", 10000.0},
+                                          {"diffusion.txt", 3000.0},
+                                          {"brownian.txt", 300.0},
+                                          {"p2000.txt", 100.0}};
+
+#if defined(USE_PRIORITY_QUEUE_VECTOR)
+    fmt::print("\nCollisionSystem::simulate, event queue: sorted vector\n");
+#elif defined(USE_PAIRING_HEAP)
+    fmt::print("\nCollisionSystem::simulate, event queue: pairing heap\n");
+#elif defined(USE_RADIX_HEAP)
+    fmt::print("\nCollisionSystem::simulate, event queue: radix heap\n");
+#elif defined(USE_CALENDAR_QUEUE)
+    fmt::print("\nCollisionSystem::simulate, event queue: calendar queue\n");
+#else
+    fmt::print("\nCollisionSystem::simulate, event queue: heap D={}\n", PRIORITY_QUEUE_ARITY);
+#endif
+    fmt::print("prediction threads: {}\n", CollisionSystem{std::vector<Particle>{}}.threads);
+    fmt::print("{:<18} {:>10} {:>12} {:>12} {:>12} {:>12}\n", "scenario", "sim time", "lazy (s)",
+               "indexed (s)", "lazy+grid", "indexed+grid");
+
+    using Scheduling = CollisionSystem::Scheduling;
+    using BroadPhase = CollisionSystem::BroadPhase;
+    const std::pair<Scheduling, BroadPhase> configurations[] = {
+        {Scheduling::Lazy, BroadPhase::AllPairs},
+        {Scheduling::Indexed, BroadPhase::AllPairs},
+        {Scheduling::Lazy, BroadPhase::Grid},
+        {Scheduling::Indexed, BroadPhase::Grid}};
+
+    for (const auto& [file, simulationTime] : scenarios) {
+        std::vector<double> seconds;
+        for (const auto& [scheduling, broadPhase] : configurations) {
+            CollisionSystem system{read_particles(data_dir / file)};
+            system.scheduling = scheduling;
+            system.broadPhase = broadPhase;
+
+            const auto start = std::chrono::steady_clock::now();
+            system.simulate(simulationTime, 10);
+            const auto stop = std::chrono::steady_clock::now();
+
+            seconds.push_back(std::chrono::duration<double>(stop - start).count());
+        }
+
+        fmt::print("{:<18} {:>10.0f} {:>12.3f} {:>12.3f} {:>12.3f} {:>12.3f}\n", file,
+                   simulationTime, seconds[0], seconds[1], seconds[2], seconds[3]);
+    }
+}
+
+}  // namespace
+
+/*
+ * Compare the event queues on a synthetic event workload and time the simulation
+ * To compare them in the simulation, configure with -DPRIORITY_QUEUE_ARITY=2 (4, 8)
+ * or -DEVENT_QUEUE=PRIORITY_QUEUE_VECTOR (PAIRING_HEAP, RADIX_HEAP, CALENDAR_QUEUE)
+ */
+int main() {
+    benchmarkQueues();
+    benchmarkSeeding();
+    benchmarkSimulation();
+}
@@ -0,0 +1,72 @@
+#include <string>
+#include <fstream>
+#include <filesystem>
+
+#include <fmt/format.h>
+
+namespace {
+
+/**
+ * Read the next line of a trace that is not a comment
+ * Return false at the end of the trace
+ */
+bool nextLine(std::ifstream& is, std::string& line) {
+    while (std::getline(is, line)) {
+        if (!line.empty() && line.front() != '#') {
+            return true;
+        }
+    }
+    return false;
+}
+
+}  // namespace
+
+/*
+ * Compare two traces written by lab3-headless --trace, line by line, and report the first
+ * time at which the states of the two runs differ
+ * Exit with 0 if the traces are equal, 1 if they differ and 2 if they cannot be read
+ */
+int main(int argc, char* argv[]) {
+    if (argc != 3) {
+        fmt::print(stderr, "Usage: lab3-difftrace <trace> <trace>\n");
+        return 2;
+    }
+
+    const std::filesystem::path files[2] = {argv[1], argv[2]};
+    std::ifstream traces[2] = {std::ifstream{files[0]}, std::ifstream{files[1]}};
+    for (int k = 0; k < 2; ++k) {
+        if (!traces[k]) {
+            fmt::print(stderr, "Could not read {}\n", files[k].string());
+            return 2;
+        }
+    }
+
+    std::string lines[2];
+    std::string last;  // time of the last equal state
+    int equal = 0;     // number of equal states
+    while (true) {
+        const bool more[2] = {nextLine(traces[0], lines[0]), nextLine(traces[1], lines[1])};
+        if (!more[0] && !more[1]) {
+            break;
+        }
+        if (more[0] != more[1]) {
+            fmt::print("{} ends after {} equal states\n", files[more[0] ? 1 : 0].string(),
+                       equal);
+            return 1;
+        }
+        if (lines[0] != lines[1]) {
+            fmt::print("the runs diverge after {} equal states", equal);
+            if (!last.empty()) {
+                fmt::print(", the last one at time {}", last);
+            }
+            fmt::print("\n  {}: {}\n  {}: {}\n", files[0].string(), lines[0], files[1].string(),
+                       lines[1]);
+            return 1;
+        }
+
+        last = lines[0].substr(0, lines[0].find(' '));
+        ++equal;
+    }
+
+    fmt::print("{} equal states\n", equal);
+}
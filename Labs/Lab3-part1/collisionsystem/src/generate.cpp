@@ -0,0 +1,103 @@
+#include <string>
+#include <string_view>
+#include <filesystem>
+#include <cstdio>
+#include <cstdint>
+
+#include <particlesystem/randomparticles.h>
+#include <particlesystem/readfiles.h>
+
+#include <fmt/format.h>
+
+using namespace particlesystem;
+
+namespace {
+
+/**
+ * Options of the generator, given on the command line
+ */
+struct Options {
+    long long n = 0;             // number of particles
+    std::filesystem::path file;  // output file
+    double fraction = 0.2;       // fraction of the unit box covered by the particles
+    double speed = 0.01;         // standard deviation of each velocity component
+    double mass = 0.01;          // mass of each particle
+    std::uint32_t seed = 1;      // seed of the random number generator
+};
+
+void printUsage() {
+    fmt::print(stderr,
+               "Usage: lab3-generate <number of particles> <output file> [options]\n"
+               "  --fraction <f>   fraction of the box covered by particles (default 0.2)\n"
+               "  --speed <s>      standard deviation of the velocity components (default 0.01)\n"
+               "  --mass <m>       mass of each particle (default 0.01)\n"
+               "  --seed <s>       seed of the random numbers (default 1)\n");
+}
+
+/**
+ * Parse the command line
+ * Return false if it is not valid
+ */
+bool parseOptions(int argc, char* argv[], Options& options) {
+    if (argc < 3) {
+        return false;
+    }
+
+    try {
+        options.n = std::stoll(argv[1]);
+        options.file = argv[2];
+
+        for (int i = 3; i < argc; ++i) {
+            const std::string_view option = argv[i];
+            if (i + 1 == argc) {  // all options take a value
+                return false;
+            }
+
+            if (option == "--fraction") {
+                options.fraction = std::stod(argv[++i]);
+            } else if (option == "--speed") {
+                options.speed = std::stod(argv[++i]);
+            } else if (option == "--mass") {
+                options.mass = std::stod(argv[++i]);
+            } else if (option == "--seed") {
+                options.seed = static_cast<std::uint32_t>(std::stoul(argv[++i]));
+            } else {
+                return false;
+            }
+        }
+    } catch (const std::exception&) {  // a number could not be converted
+        return false;
+    }
+
+    return options.n > 0 && options.fraction > 0.0 && options.fraction < 0.5 &&
+           options.speed >= 0.0 && options.mass > 0.0;
+}
+
+}  // namespace
+
+/*
+ * Write a random configuration of n particles of equal radius, without overlaps, for scaling
+ * benchmarks of CollisionSystem
+ */
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage();
+        return 1;
+    }
+
+    const auto particles = random_particles(options.n, options.fraction, options.speed,
+                                            options.mass, options.seed);
+    if (particles.empty()) {
+        fmt::print(stderr, "Could not place {} particles covering {} of the box\n", options.n,
+                   options.fraction);
+        return 1;
+    }
+
+    if (!write_particles(options.file, particles)) {
+        fmt::print(stderr, "Could not write {}\n", options.file.string());
+        return 1;
+    }
+    fmt::print("{} particles of radius {:.3g} written to {}\n", particles.size(),
+               particles.front().radius, options.file.string());
+}
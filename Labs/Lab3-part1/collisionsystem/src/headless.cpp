@@ -0,0 +1,239 @@
+#include <vector>
+#include <string>
+#include <string_view>
+#include <filesystem>
+#include <cmath>
+#include <cstdio>
+#include <span>
+#include <optional>
+#include <memory>
+#include <cstdint>
+
+#include <particlesystem/collisionsystem.h>
+#include <particlesystem/readfiles.h>
+#include <particlesystem/checkpoint.h>
+
+#include <fmt/format.h>
+
+using namespace particlesystem;
+
+namespace {
+
+/**
+ * Options of a headless run, given on the command line
+ */
+struct Options {
+    std::filesystem::path particlesFile;
+    double simulationTime = 0.0;
+    CollisionSystem::Scheduling scheduling = CollisionSystem::Scheduling::Lazy;
+    CollisionSystem::BroadPhase broadPhase = CollisionSystem::BroadPhase::AllPairs;
+    int threads = 0;                       // 0 for the default of CollisionSystem
+    int regions = 0;                       // regions of region scheduling, 0 for one per thread
+    bool timing = false;                   // measure the phases of the event loop
+    double reportInterval = 0.0;           // time units between progress reports, 0 for none
+    std::filesystem::path output;          // final state, if not empty
+    bool restart = false;                  // particlesFile is a checkpoint
+    double checkpointInterval = 0.0;       // time units between checkpoints, 0 for none
+    std::filesystem::path checkpointFile;  // file of the checkpoints
+    bool deterministic = false;            // deterministic mode of CollisionSystem
+    double horizon = 0.0;                  // prediction horizon, 0 for none
+    double compaction = -1.0;              // compaction threshold, negative for the default
+    double traceInterval = 0.0;            // time units between state hashes, 0 for none
+    std::filesystem::path traceFile;       // file of the state hashes
+    double frameFrequency = 0.0;           // frames written per time unit, 0 for none
+    std::filesystem::path frameDirectory;  // directory of the frames
+};
+
+void printUsage() {
+    fmt::print(stderr,
+               "Usage: lab3-headless <particles file> <simulation time> [options]\n"
+               "  --indexed               indexed event queue (default lazy)\n"
+               "  --grid                  cell grid broad phase (default all pairs)\n"
+               "  --regions <n>           process n regions of the grid in parallel (0: threads)\n"
+               "  --threads <n>           number of prediction threads\n"
+               "  --timing                measure the time of predict, queue and move\n"
+               "  --report <dt>           print the counters every dt time units\n"
+               "  --output <file>         write the final particles to file\n"
+               "  --checkpoint <dt> <file> write a binary checkpoint every dt time units\n"
+               "  --restart               the particles file is a checkpoint to restart from\n"
+               "  --horizon <dt>          only queue the events within dt of their prediction\n"
+               "  --compaction <f>        compact the queue above a fraction f of stale events\n"
+               "  --deterministic         results independent of rendering, queue and threads\n"
+               "  --trace <dt> <file>     write the hash of the state every dt time units\n"
+               "  --frames <f> <dir>      write the particles f times per time unit to dir\n");
+}
+
+/**
+ * Parse the command line
+ * Return false if it is not valid
+ */
+bool parseOptions(int argc, char* argv[], Options& options) {
+    if (argc < 3) {
+        return false;
+    }
+
+    options.particlesFile = argv[1];
+    try {
+        options.simulationTime = std::stod(argv[2]);
+
+        for (int i = 3; i < argc; ++i) {
+            const std::string_view option = argv[i];
+            const int remaining = argc - i - 1;  // arguments after option
+
+            if (option == "--indexed") {
+                options.scheduling = CollisionSystem::Scheduling::Indexed;
+            } else if (option == "--grid") {
+                options.broadPhase = CollisionSystem::BroadPhase::Grid;
+            } else if (option == "--regions" && remaining >= 1) {
+                options.scheduling = CollisionSystem::Scheduling::Regions;
+                options.regions = std::stoi(argv[++i]);
+            } else if (option == "--threads" && remaining >= 1) {
+                options.threads = std::stoi(argv[++i]);
+            } else if (option == "--timing") {
+                options.timing = true;
+            } else if (option == "--report" && remaining >= 1) {
+                options.reportInterval = std::stod(argv[++i]);
+            } else if (option == "--output" && remaining >= 1) {
+                options.output = argv[++i];
+            } else if (option == "--checkpoint" && remaining >= 2) {
+                options.checkpointInterval = std::stod(argv[++i]);
+                options.checkpointFile = argv[++i];
+            } else if (option == "--restart") {
+                options.restart = true;
+            } else if (option == "--horizon" && remaining >= 1) {
+                options.horizon = std::stod(argv[++i]);
+            } else if (option == "--compaction" && remaining >= 1) {
+                options.compaction = std::stod(argv[++i]);
+            } else if (option == "--deterministic") {
+                options.deterministic = true;
+            } else if (option == "--trace" && remaining >= 2) {
+                options.traceInterval = std::stod(argv[++i]);
+                options.traceFile = argv[++i];
+            } else if (option == "--frames" && remaining >= 2) {
+                options.frameFrequency = std::stod(argv[++i]);
+                options.frameDirectory = argv[++i];
+            } else {
+                return false;
+            }
+        }
+    } catch (const std::exception&) {  // std::stod or std::stoi failed
+        return false;
+    }
+
+    return options.simulationTime > 0.0 && options.threads >= 0 && options.regions >= 0 &&
+           options.frameFrequency >= 0.0 && options.reportInterval >= 0.0 &&
+           options.checkpointInterval >= 0.0 && options.traceInterval >= 0.0 &&
+           options.horizon >= 0.0;
+}
+
+}  // namespace
+
+/*
+ * Run the simulation without a window, at full speed, and report its throughput
+ */
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage();
+        return 1;
+    }
+
+    // a particles file is a checkpoint at time 0
+    std::optional<Checkpoint> checkpoint;
+    if (options.restart) {
+        checkpoint = read_checkpoint(options.particlesFile);
+    } else {
+        checkpoint = Checkpoint{.time = 0.0, .particles = read_particles(options.particlesFile)};
+    }
+    if (!checkpoint || checkpoint->particles.empty()) {
+        fmt::print(stderr, "No particles in {}\n", options.particlesFile.string());
+        return 1;
+    }
+
+    CollisionSystem system{std::move(*checkpoint)};
+    system.scheduling = options.scheduling;
+    system.broadPhase = options.broadPhase;
+    system.regions = options.regions;
+    if (options.threads > 0) {
+        system.threads = options.threads;
+    }
+    system.timing = options.timing;
+    system.deterministic = options.deterministic;
+    if (options.horizon > 0.0) {
+        system.predictionHorizon = options.horizon;
+    }
+    if (options.compaction >= 0.0) {
+        system.compactionThreshold = options.compaction;
+    }
+    if (options.reportInterval > 0.0) {
+        system.reportInterval = options.reportInterval;
+        system.reportCallback = [](const CollisionSystem::Statistics& statistics) {
+            fmt::print("{}\n", statistics.report());
+        };
+    }
+
+    // rendering events only happen if frames are written
+    int frame = 0;
+    if (options.frameFrequency > 0.0) {
+        std::filesystem::create_directories(options.frameDirectory);
+        system.renderCallback = [&](std::span<Particle> state) {
+            const auto file = options.frameDirectory / fmt::format("frame{:06}.txt", frame++);
+            if (!write_particles(file, state)) {
+                fmt::print(stderr, "Could not write {}\n", file.string());
+            }
+        };
+    }
+
+    // checkpoints are written while the simulation goes on
+    std::optional<CheckpointWriter> writer;
+    if (options.checkpointInterval > 0.0) {
+        writer.emplace(options.checkpointFile);
+        system.checkpointInterval = options.checkpointInterval;
+        system.checkpointCallback = [&](std::vector<Particle> state, double time) {
+            writer->write(std::move(state), time);
+        };
+    }
+
+    // one line per hash, compared by lab3-difftrace
+    std::unique_ptr<std::FILE, int (*)(std::FILE*)> trace{nullptr, &std::fclose};
+    if (options.traceInterval > 0.0) {
+        trace.reset(std::fopen(options.traceFile.string().c_str(), "w"));
+        if (!trace) {
+            fmt::print(stderr, "Could not write {}\n", options.traceFile.string());
+            return 1;
+        }
+        fmt::print(trace.get(), "# time hash\n");
+        system.traceInterval = options.traceInterval;
+        system.traceCallback = [&](double time, std::uint64_t hash) {
+            fmt::print(trace.get(), "{:.17g} {:016x}\n", time, hash);
+        };
+    }
+
+    const double energy = system.kineticEnergy();
+    const double startTime = system.time();
+    system.simulate(options.simulationTime, options.frameFrequency);
+    const double drift = energy > 0.0 ? (system.kineticEnergy() - energy) / energy : 0.0;
+
+    fmt::print("particles         {}\n", system.particles().size());
+    if (options.restart) {
+        fmt::print("restarted at      {:.3f}\n", startTime);
+    }
+    fmt::print("threads           {}\n", system.threads);
+    fmt::print("{}", system.statistics().report());
+    fmt::print("energy drift      {:.3e}\n", drift);
+
+    if (writer) {
+        writer->wait();
+        const int failed = writer->failed();
+        fmt::print("checkpoints       {} written to {}\n", writer->written(),
+                   options.checkpointFile.string());
+        if (failed > 0) {
+            fmt::print(stderr, "Could not write {} checkpoints\n", failed);
+        }
+    }
+
+    if (!options.output.empty() && !write_particles(options.output, system.particles())) {
+        fmt::print(stderr, "Could not write {}\n", options.output.string());
+        return 1;
+    }
+}
@@ -7,9 +7,20 @@
 #include <filesystem>
 #include <algorithm>
 #include <numeric>
+#include <span>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <cstdint>
 
 #include <particlesystem/particle.h>
 #include <particlesystem/collisionsystem.h>
+#include <particlesystem/priorityqueue-vector.h>
+#include <particlesystem/readfiles.h>
+#include <particlesystem/randomparticles.h>
+#include <particlesystem/snapshotbuffer.h>
+#include <particlesystem/checkpoint.h>
 
 #include <rendering/window.h>
 
@@ -23,9 +34,24 @@ using namespace particlesystem;
 void test4PriorityQueue();
 
 /**
- * Read particles for the simulation from file
+ * To test insert, insertBatch and removeIf of the sorted vector queue
  */
-std::vector<Particle> read_particles(const std::filesystem::path& file);
+void test4SortedVectorQueue();
+
+/**
+ * To test decreaseKey, increaseKey and erase of the indexed priority queue
+ */
+void test4IndexedPriorityQueue();
+
+/**
+ * To test that region scheduling processes the same events as lazy scheduling
+ */
+void test4RegionScheduling();
+
+/**
+ * To test that a checkpoint is read back as written, and that damaged files are rejected
+ */
+void test4Checkpoint();
 
 /**
  * To run the simulation
@@ -35,44 +61,15 @@ void runSimulation();
 int main() {
 #ifdef TEST_PRIORITY_QUEUE
     test4PriorityQueue();
+    test4SortedVectorQueue();
+    test4IndexedPriorityQueue();
+    test4RegionScheduling();
+    test4Checkpoint();
 #else
     runSimulation();
 #endif
 }
 
-/**
- * Read particles for the simulation from file
- */
-std::vector<Particle> read_particles(const std::filesystem::path& file) {
-    std::ifstream is(file);
-    if (!is) {
-        return {};
-    }
-
-    int n_particles;
-    is >> n_particles;  // read number of particles
-
-    std::vector<Particle> particles;
-    particles.reserve(n_particles);
-
-    double rx, ry;
-    double vx, vy;
-    double radius;
-    double mass;
-    float r, g, b;
-    for (int i = 0; i < n_particles; ++i) {
-        is >> rx >> ry >> vx >> vy;
-        is >> radius >> mass;
-        is >> r >> g >> b;
-        particles.push_back(Particle{.r = {rx, ry},
-                                     .v = {vx, vy},
-                                     .radius = radius,
-                                     .mass = mass,
-                                     .color = {r / 255.0f, g / 255.0f, b / 255.0f}});
-    }
-    return particles;
-}
-
 void runSimulation() {
     /*
     * billiards10.txt, diffusion.txt, sam4.txt, brownian.txt, sam4.txt
@@ -93,19 +90,44 @@ void runSimulation() {
     // create collision system
     CollisionSystem system{std::move(theParticles)};
 
-    // Some initializations for rendering
-    rendering::Window window(850, 850, rendering::Window::UseVSync::No);
+    // The simulation runs on a thread of its own and hands a copy of the particles to the
+    // window at each rendering event. The window draws the latest copy at its own pace,
+    // so the simulation never waits for the GPU or for vsync. The last state stays on
+    // screen until the window is closed
+    SnapshotBuffer snapshots;
+    std::atomic<bool> closed = false;  // the user closed the window
+
+    // The simulation sleeps until each frame is due, at 60 frames per second, so that every
+    // rendering event is shown. A simulation slower than that is not made to catch up
+    constexpr auto framePeriod = std::chrono::microseconds{16'667};
+    auto nextFrame = std::chrono::steady_clock::now();
     system.renderCallback = [&](std::span<Particle> particles) {
+        snapshots.publish(particles);
+        nextFrame = std::max(nextFrame + framePeriod, std::chrono::steady_clock::now());
+        std::this_thread::sleep_until(nextFrame);
+    };
+    system.abortCallback = [&]() { return closed.load(); };
+
+    // Some initializations for rendering
+    rendering::Window window(850, 850, rendering::Window::UseVSync::Yes);
+
+    fmt::print("Simulation starts ...\n");
+    nextFrame = std::chrono::steady_clock::now();
+    std::thread simulation{[&] {
+        system.simulate(10000, 10);  // simulate
+        fmt::print("Simulation ends ...\n");
+    }};
+
+    while (!window.shouldClose()) {
+        snapshots.acquire();
         window.beginFrame();
         window.clear({0, 0, 0, 1});
-        window.drawParticles(particles);
+        window.drawParticles(snapshots.front());
         window.endFrame();
-    };
-    system.abortCallback = [&]() { return window.shouldClose(); };
+    }
 
-    fmt::print("Simulation starts ...\n");
-    system.simulate(10000, 10);  // simulate
-    fmt::print("Simulation ends ...\n");
+    closed = true;
+    simulation.join();
 }
 
 /**
@@ -141,5 +163,242 @@ void test4PriorityQueue() {
             fmt::print("Oops! Error after delete of {}\n", i);
         }
     }
+
+    fmt::print("Test: insertBatch\n");
+
+    // a small batch is inserted element by element, a large one rebuilds the heap
+    h.insertBatch(std::span{V}.first(10));
+    h.insertBatch(std::span{V}.subspan(10));
+    assert(h.size() == V.size());
+
+    for (int i = minItem; i < maxItem; ++i) {
+        int x = h.deleteMin();
+        if (x != i) {
+            fmt::print("Oops! Error after delete of {}\n", i);
+        }
+    }
+
+    fmt::print("Test: removeIf\n");
+
+    h.insertBatch(V);
+    const std::size_t removed = h.removeIf([](int x) { return x % 2 != 0; });
+    assert(removed == V.size() / 2);
+    assert(h.size() == V.size() - removed);
+
+    for (int i = minItem; i < maxItem; i += 2) {
+        int x = h.deleteMin();
+        if (x != i) {
+            fmt::print("Oops! Error after delete of {}\n", i);
+        }
+    }
+    assert(h.isEmpty());
+    fmt::print("Successful test...\n");
+}
+
+/**
+ * To test insert, insertBatch and removeIf of the sorted vector queue
+ * The batches are merged with a queue that is larger, and then smaller, than the batch
+ */
+void test4SortedVectorQueue() {
+    constexpr int minItem = 1000;
+    constexpr int maxItem = 9999;
+    SortedVectorQueue<int> h;
+
+    fmt::print("Test: SortedVectorQueue insert, deleteMin\n");
+
+    std::vector<int> V(8999, 0);
+    std::random_device rd;
+    std::mt19937 g(rd());
+    std::iota(V.begin(), V.end(), minItem);
+    std::shuffle(V.begin(), V.end(), g);
+
+    for (int k : V) {
+        h.insert(k);
+    }
+
+    for (int i = minItem; i < maxItem; ++i) {
+        int x = h.deleteMin();
+        if (x != i) {
+            fmt::print("Oops! Error after delete of {}\n", i);
+        }
+    }
+    assert(h.isEmpty());
+
+    fmt::print("Test: SortedVectorQueue insertBatch\n");
+
+    // a batch into the empty queue, one smaller than the queue and one larger than it
+    h.insertBatch(std::span{V}.first(1000));
+    h.insertBatch(std::span{V}.subspan(1000, 10));
+    h.insertBatch(std::span{V}.subspan(1010));
+    assert(h.size() == V.size());
+
+    for (int i = minItem; i < maxItem; ++i) {
+        int x = h.deleteMin();
+        if (x != i) {
+            fmt::print("Oops! Error after delete of {}\n", i);
+        }
+    }
+
+    fmt::print("Test: SortedVectorQueue removeIf\n");
+
+    h.insertBatch(V);
+    const std::size_t removed = h.removeIf([](int x) { return x % 2 != 0; });
+    assert(removed == V.size() / 2);
+    assert(h.size() == V.size() - removed);
+
+    for (int i = minItem; i < maxItem; i += 2) {
+        int x = h.deleteMin();
+        if (x != i) {
+            fmt::print("Oops! Error after delete of {}\n", i);
+        }
+    }
+    assert(h.isEmpty());
+    fmt::print("Successful test...\n");
+}
+
+/**
+ * To test decreaseKey, increaseKey and erase of the indexed priority queue
+ */
+void test4IndexedPriorityQueue() {
+    constexpr int n = 1000;
+    IndexedPriorityQueue<int> h(n);
+
+    fmt::print("Test: insert, decreaseKey, increaseKey, erase, deleteMin\n");
+
+    std::vector<int> V(n, 0);
+    std::random_device rd;
+    std::mt19937 g(rd());
+    std::iota(V.begin(), V.end(), 0);
+    std::shuffle(V.begin(), V.end(), g);
+
+    // handle i gets key 2*V[i] + 1, then every key is moved to 2*V[i] or 2*V[i] + 2
+    for (int i = 0; i < n; ++i) {
+        h.insert(i, 2 * V[i] + 1);
+    }
+    for (int i = 0; i < n; ++i) {
+        if (i % 2 == 0) {
+            h.decreaseKey(i, 2 * V[i]);
+        } else {
+            h.increaseKey(i, 2 * V[i] + 2);
+        }
+    }
+
+    // erase the handles with odd V[i]
+    for (int i = 0; i < n; ++i) {
+        if (V[i] % 2 == 1) {
+            h.erase(i);
+        }
+    }
+
+    int previous = -1;
+    while (!h.isEmpty()) {
+        const int key = h.key(h.findMin());
+        const int i = h.deleteMin();
+        if (V[i] % 2 == 1 || key < previous || key != (i % 2 == 0 ? 2 * V[i] : 2 * V[i] + 2)) {
+            fmt::print("Oops! Error at handle {}\n", i);
+        }
+        previous = key;
+    }
+    fmt::print("Successful test...\n");
+}
+
+/**
+ * To test that region scheduling processes the same events as lazy scheduling
+ * The events undone at the end of the windows are subtracted from the counters, so without
+ * compaction the counters of the two runs are equal, as are the final particles
+ */
+void test4RegionScheduling() {
+    const auto particles = random_particles(4000, 0.2, 0.01, 0.01, 1);
+
+    fmt::print("Test: region scheduling\n");
+
+    const auto run = [&](CollisionSystem::Scheduling scheduling) {
+        auto system = std::make_unique<CollisionSystem>(particles);
+        system->broadPhase = CollisionSystem::BroadPhase::Grid;
+        system->scheduling = scheduling;
+        system->compactionThreshold = 1.0;
+        system->regions = 4;
+        system->threads = 2;
+        system->simulate(2.0, 0.0);
+        return system;
+    };
+    const auto lazy = run(CollisionSystem::Scheduling::Lazy);
+    const auto regions = run(CollisionSystem::Scheduling::Regions);
+
+    const auto& s1 = lazy->statistics();
+    const auto& s2 = regions->statistics();
+    if (s1.events != s2.events || s1.invalidated != s2.invalidated ||
+        s1.predictions != s2.predictions || s1.queueInserts != s2.queueInserts ||
+        s1.queueRemovals != s2.queueRemovals || s2.windows == 0) {
+        fmt::print("Oops! Error in the counters\n{}\n{}\n", s1.report(), s2.report());
+    }
+
+    for (std::size_t i = 0; i < particles.size(); ++i) {
+        const Particle& p = lazy->particles()[i];
+        const Particle& q = regions->particles()[i];
+        if (p.r != q.r || p.v != q.v || p.counter() != q.counter()) {
+            fmt::print("Oops! Error at particle {}\n", i);
+        }
+    }
+    fmt::print("Successful test...\n");
+}
+
+/**
+ * To test that a checkpoint is read back as written, and that damaged files are rejected
+ * The number of particles in the header of a damaged file does not match its size
+ */
+void test4Checkpoint() {
+    auto particles = random_particles(1000, 0.2, 0.01, 0.01, 1);
+    for (std::size_t i = 0; i < particles.size(); ++i) {
+        particles[i].count = static_cast<int>(i % 7);
+    }
+
+    fmt::print("Test: write_checkpoint, read_checkpoint\n");
+
+    const auto file = std::filesystem::temp_directory_path() / "lab3-test-checkpoint.bin";
+    if (!write_checkpoint(file, particles, 1.5)) {
+        fmt::print("Oops! Error writing {}\n", file.string());
+        return;
+    }
+
+    const auto checkpoint = read_checkpoint(file);
+    if (!checkpoint || checkpoint->time != 1.5 ||
+        checkpoint->particles.size() != particles.size()) {
+        fmt::print("Oops! Error reading {}\n", file.string());
+        return;
+    }
+    for (std::size_t i = 0; i < particles.size(); ++i) {
+        const Particle& p = particles[i];
+        const Particle& q = checkpoint->particles[i];
+        if (p.r != q.r || p.v != q.v || p.radius != q.radius || p.mass != q.mass ||
+            p.color.r != q.color.r || p.color.g != q.color.g || p.color.b != q.color.b ||
+            p.count != q.count || q.time != 1.5) {
+            fmt::print("Oops! Error at particle {}\n", i);
+        }
+    }
+
+    // a header asking for 2^40 particles, a file cut in the middle of a record, and a file
+    // with bytes after the last record
+    {
+        std::fstream os(file, std::ios::binary | std::ios::in | std::ios::out);
+        const std::uint64_t n = std::uint64_t{1} << 40;
+        os.seekp(16);
+        os.write(reinterpret_cast<const char*>(&n), sizeof(n));
+    }
+    if (read_checkpoint(file)) {
+        fmt::print("Oops! Error: damaged header accepted\n");
+    }
+    write_checkpoint(file, particles, 1.5);
+    std::filesystem::resize_file(file, std::filesystem::file_size(file) - 10);
+    if (read_checkpoint(file)) {
+        fmt::print("Oops! Error: truncated file accepted\n");
+    }
+    write_checkpoint(file, particles, 1.5);
+    std::filesystem::resize_file(file, std::filesystem::file_size(file) + 10);
+    if (read_checkpoint(file)) {
+        fmt::print("Oops! Error: trailing bytes accepted\n");
+    }
+
+    std::filesystem::remove(file);
     fmt::print("Successful test...\n");
 }
@@ -0,0 +1,86 @@
+#include <particlesystem/cellgrid.h>
+
+#include <cmath>
+#include <cassert>
+
+namespace particlesystem {
+
+/**
+ * Place the particles in a grid with about one particle per cell
+ * The side of a cell must not be smaller than twice the largest radius
+ */
+void CellGrid::build(std::span<const Particle> particles) {
+    double maxRadius = 0.0;
+    for (const auto& p : particles) {
+        maxRadius = std::max(maxRadius, p.radius);
+    }
+
+    // a small margin keeps touching particles in neighbouring cells despite round-off
+    const double maxResolution = std::floor(1.0 / (2.0 * maxRadius * (1.0 + 1e-9)));
+    const double resolution = std::ceil(std::sqrt(static_cast<double>(particles.size())));
+    m = static_cast<int>(std::clamp(std::min(resolution, maxResolution), 1.0, 4096.0));
+
+    cells.assign(m * m, {});
+    cellX.resize(particles.size());
+    cellY.resize(particles.size());
+
+    for (int i = 0; i < std::ssize(particles); ++i) {
+        cellX[i] = std::clamp(static_cast<int>(particles[i].r.x * m), 0, m - 1);
+        cellY[i] = std::clamp(static_cast<int>(particles[i].r.y * m), 0, m - 1);
+        cells[cellX[i] + m * cellY[i]].push_back(i);
+    }
+}
+
+/**
+ * Returns the amount of time for particle i, currently at p, to cross into an adjacent cell
+ * Return std::numeric_limits<double>::infinity(), if the particle does not leave its cell
+ */
+double CellGrid::timeToCross(int i, const Particle& p) const {
+    return std::min(timeToCross(cellX[i], p.r.x, p.v.x), timeToCross(cellY[i], p.r.y, p.v.y));
+}
+
+/**
+ * Column of the cell that particle i, currently at p, is crossing into
+ * It is the column of i if the particle crosses into the next row, as in cross
+ */
+int CellGrid::nextColumn(int i, const Particle& p) const {
+    const double tX = timeToCross(cellX[i], p.r.x, p.v.x);
+    const double tY = timeToCross(cellY[i], p.r.y, p.v.y);
+    if (tX <= tY) {
+        return cellX[i] + (p.v.x > 0 ? 1 : -1);
+    }
+    return cellX[i];
+}
+
+/**
+ * Move the particle of crossing back to the cell it left
+ * The particle was the last one added to its cell, unless a later crossing is not undone yet
+ */
+void CellGrid::undo(const Crossing& crossing) {
+    const int i = crossing.i;
+    auto& to = cells[cellX[i] + m * cellY[i]];
+    assert(!to.empty() && to.back() == i);
+    to.pop_back();
+
+    cellX[i] = crossing.x;
+    cellY[i] = crossing.y;
+    auto& from = cells[cellX[i] + m * cellY[i]];
+    from.insert(from.begin() + crossing.position, i);
+}
+
+/**
+ * Amount of time for a particle at position r, with velocity v, in column/row c of the grid
+ * to cross into the next column/row
+ * Return std::numeric_limits<double>::infinity(), if the next column/row is outside the grid
+ */
+double CellGrid::timeToCross(int c, double r, double v) const {
+    if (v > 0 && c + 1 < m) {
+        return std::max(0.0, (static_cast<double>(c + 1) / m - r) / v);
+    } else if (v < 0 && c > 0) {
+        return std::max(0.0, (static_cast<double>(c) / m - r) / v);
+    } else {
+        return std::numeric_limits<double>::infinity();
+    }
+}
+
+}  // namespace particlesystem
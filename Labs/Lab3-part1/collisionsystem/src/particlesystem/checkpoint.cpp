@@ -0,0 +1,203 @@
+#include <particlesystem/checkpoint.h>
+
+#include <fstream>
+#include <cstdint>
+#include <cstring>
+#include <system_error>
+
+namespace particlesystem {
+
+namespace {
+
+constexpr char magic[8] = {'P', 'A', 'R', 'T', 'C', 'H', 'K', 'P'};
+constexpr std::uint32_t version = 1;
+
+/**
+ * Header of a checkpoint file
+ */
+struct Header {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t recordSize;  // bytes per particle, to detect files of another build
+    std::uint64_t n;           // number of particles
+    double time;               // simulation time of the checkpoint
+};
+
+/**
+ * The state of one particle in a checkpoint file
+ */
+struct Record {
+    double rx, ry;
+    double vx, vy;
+    double radius;
+    double mass;
+    float red, green, blue;
+    std::int32_t count;
+};
+
+static_assert(sizeof(Header) == 32);
+static_assert(sizeof(Record) == 64);
+
+}  // namespace
+
+/**
+ * Write a checkpoint of particles at time to file, in a binary format
+ * The file is written next to file and then renamed, so that file always holds a complete
+ * checkpoint. Return false if the file cannot be written
+ */
+bool write_checkpoint(const std::filesystem::path& file, std::span<const Particle> particles,
+                      double time) {
+    Header header{};
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.version = version;
+    header.recordSize = sizeof(Record);
+    header.n = particles.size();
+    header.time = time;
+
+    std::vector<Record> records;
+    records.reserve(particles.size());
+    for (const auto& p : particles) {
+        records.push_back(Record{.rx = p.r.x,
+                                 .ry = p.r.y,
+                                 .vx = p.v.x,
+                                 .vy = p.v.y,
+                                 .radius = p.radius,
+                                 .mass = p.mass,
+                                 .red = p.color.r,
+                                 .green = p.color.g,
+                                 .blue = p.color.b,
+                                 .count = p.count});
+    }
+
+    auto temporary = file;
+    temporary += ".tmp";
+    {
+        std::ofstream os(temporary, std::ios::binary);
+        os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        os.write(reinterpret_cast<const char*>(records.data()),
+                 static_cast<std::streamsize>(records.size() * sizeof(Record)));
+        if (!os) {
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporary, file, error);
+    return !error;
+}
+
+/**
+ * Read a checkpoint written by write_checkpoint
+ * Return std::nullopt if the file cannot be read or is not a checkpoint
+ */
+std::optional<Checkpoint> read_checkpoint(const std::filesystem::path& file) {
+    std::ifstream is(file, std::ios::binary);
+    Header header;
+    if (!is.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, magic, sizeof(magic)) != 0 || header.version != version ||
+        header.recordSize != sizeof(Record)) {
+        return std::nullopt;
+    }
+
+    // n is checked against the size of the file before the records are allocated, a damaged
+    // header must not ask for more memory than the file can hold, and the file must end after
+    // the last record
+    std::error_code error;
+    const auto size = std::filesystem::file_size(file, error);
+    if (error || size < sizeof(Header) || (size - sizeof(Header)) % sizeof(Record) != 0 ||
+        header.n != (size - sizeof(Header)) / sizeof(Record)) {
+        return std::nullopt;
+    }
+
+    // the records are read in one block
+    std::vector<Record> records(header.n);
+    if (!is.read(reinterpret_cast<char*>(records.data()),
+                 static_cast<std::streamsize>(records.size() * sizeof(Record)))) {
+        return std::nullopt;
+    }
+
+    Checkpoint checkpoint{.time = header.time, .particles = {}};
+    checkpoint.particles.reserve(records.size());
+    for (const auto& record : records) {
+        checkpoint.particles.push_back(Particle{.r = {record.rx, record.ry},
+                                                .v = {record.vx, record.vy},
+                                                .radius = record.radius,
+                                                .mass = record.mass,
+                                                .color = {record.red, record.green, record.blue},
+                                                .count = record.count,
+                                                .time = header.time});
+    }
+    return checkpoint;
+}
+
+/**
+ * Constructor to create a writer of checkpoints to file
+ */
+CheckpointWriter::CheckpointWriter(std::filesystem::path file)
+    : file{std::move(file)}, thread{&CheckpointWriter::run, this} {}
+
+/**
+ * Destructor, writes the pending checkpoint before returning
+ */
+CheckpointWriter::~CheckpointWriter() {
+    {
+        std::lock_guard lock{mutex};
+        stop = true;
+    }
+    wake.notify_one();
+    thread.join();
+}
+
+/**
+ * Hand over a checkpoint of particles at time, without waiting for it to be written
+ */
+void CheckpointWriter::write(std::vector<Particle> particles, double time) {
+    {
+        std::lock_guard lock{mutex};
+        pending = Checkpoint{.time = time, .particles = std::move(particles)};
+    }
+    wake.notify_one();
+}
+
+/**
+ * Wait until the checkpoints handed over are written
+ */
+void CheckpointWriter::wait() {
+    std::unique_lock lock{mutex};
+    idle.wait(lock, [this] { return !pending && !busy; });
+}
+
+int CheckpointWriter::written() const {
+    std::lock_guard lock{mutex};
+    return nWritten;
+}
+
+int CheckpointWriter::failed() const {
+    std::lock_guard lock{mutex};
+    return nFailed;
+}
+
+/**
+ * Loop of the writing thread: write the pending checkpoint, until stopped with none pending
+ */
+void CheckpointWriter::run() {
+    std::unique_lock lock{mutex};
+    while (true) {
+        wake.wait(lock, [this] { return stop || pending; });
+        if (!pending) return;  // stopped
+
+        Checkpoint checkpoint = std::move(*pending);
+        pending.reset();
+        busy = true;
+        lock.unlock();
+
+        const bool ok = write_checkpoint(file, checkpoint.particles, checkpoint.time);
+
+        lock.lock();
+        ++(ok ? nWritten : nFailed);
+        busy = false;
+        if (!pending) idle.notify_all();
+    }
+}
+
+}  // namespace particlesystem
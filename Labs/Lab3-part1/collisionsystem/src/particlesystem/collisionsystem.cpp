@@ -1,8 +1,17 @@
 #include <particlesystem/collisionsystem.h>
+#include <particlesystem/statehash.h>
 
 #include <cassert>
 #include <span>
 #include <numeric>
+#include <limits>
+#include <array>
+#include <cstddef>
+#include <chrono>
+#include <cmath>
+#include <atomic>
+#include <mutex>
+#include <optional>
 #include <fmt/format.h>
 
 namespace particlesystem {
@@ -10,18 +19,201 @@ namespace particlesystem {
 namespace {
 
 /**
- * Help function to add a new event between particleA and particleB to the queue
- * The event's time must be smaller than simulationTime to be added to the queue
+ * Help function to add a new event to the events
+ * The event's time must be smaller than simulationTime to be added to the events
  */
-void addEvent(double time, Particle* particleA, Particle* particleB, PriorityQueue<Event>& queue,
-              double simulationTime) {
-    if (time < simulationTime) {
-        queue.insert(Event{time, particleA, particleB});
+void addEvent(const Event& e, std::vector<Event>& events, double simulationTime) {
+    if (e.scheduledTime() < simulationTime) {
+        events.push_back(e);
     }
 }
 
+/**
+ * Help function to add a predicted event to the events, if its time is smaller than horizon
+ * An event between horizon and simulationTime sets truncated: it must be predicted again
+ */
+void addPrediction(const Event& e, std::vector<Event>& events, double horizon,
+                   double simulationTime, bool& truncated) {
+    if (e.scheduledTime() < horizon) {
+        events.push_back(e);
+    } else if (e.scheduledTime() < simulationTime) {
+        truncated = true;
+    }
+}
+
+/**
+ * Help function to set the event of handle h in the indexed queue
+ * The event is removed from the queue if its time is not smaller than simulationTime
+ * dependents[j] holds the handles whose queued event has particle b j, it is kept up to date
+ */
+void updateEvent(int h, const Event& e, IndexedPriorityQueue<Event>& queue,
+                 std::vector<std::vector<int>>& dependents, double simulationTime) {
+    if (queue.contains(h)) {
+        if (const int b = queue.key(h).particleB(); b != Event::none) {
+            auto& handles = dependents[b];
+            *std::ranges::find(handles, h) = handles.back();
+            handles.pop_back();
+        }
+    }
+
+    if (e.scheduledTime() < simulationTime) {
+        queue.update(h, e);
+        if (const int b = e.particleB(); b != Event::none) dependents[b].push_back(h);
+    } else if (queue.contains(h)) {
+        queue.erase(h);
+    }
+}
+
+/**
+ * Adds the wall-clock time from its construction to its destruction to seconds,
+ * unless it is disabled
+ */
+class ScopedTimer {
+public:
+    ScopedTimer(bool enabled, double& seconds) : seconds_{enabled ? &seconds : nullptr} {
+        if (seconds_) start_ = std::chrono::steady_clock::now();
+    }
+
+    ~ScopedTimer() {
+        if (seconds_) {
+            const auto stop = std::chrono::steady_clock::now();
+            *seconds_ += std::chrono::duration<double>(stop - start_).count();
+        }
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    double* seconds_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+/**
+ * Help function to return the smallest multiple of interval larger than time
+ */
+double nextMultiple(double time, double interval) {
+    return interval > 0.0 ? (std::floor(time / interval) + 1.0) * interval : 0.0;
+}
+
+/**
+ * Size of the event queue below which it is never compacted
+ */
+constexpr std::size_t min_compaction_size = 1024;
+
+/**
+ * Sizes above which predictions are split between threads: the number of particles to predict
+ * at once, or the number of candidates of a single particle. Below them the cost of waking the
+ * threads is larger than the work
+ */
+constexpr std::ptrdiff_t parallel_particles = 256;
+constexpr std::ptrdiff_t parallel_candidates = 8192;
+
+/**
+ * Smallest width of a region of region scheduling, in columns of the cell grid
+ */
+constexpr int min_region_columns = 4;
+
+/**
+ * Length of a window of region scheduling, in mean times between the events that stop a window
+ * The windows are optimistic: the events after the stop are undone. The times between stops
+ * are about exponentially distributed, so a window of 0.5 mean times ends at a stop 39% of the
+ * time, and the events undone are about 27% of those kept
+ */
+constexpr double window_length = 0.5;
+
+/**
+ * Most events a region processes in one window, which bounds its undo log
+ */
+constexpr std::size_t max_window_events = 1 << 14;
+
 }  // namespace
 
+/**
+ * A region of region scheduling: the particles in a strip of columns of the cell grid, the
+ * queue of their events and the log of the events processed in the current window
+ *
+ * The particles of a region only interact with the particles of the neighbouring regions
+ * through the boundary columns, the first and last columns next to another region. An event
+ * of a particle in a boundary column, or crossing into one, stops the window of the region.
+ */
+struct CollisionSystem::Region {
+    // An event processed in the current window, and what it changed
+    struct Step {
+        Event event;               // the event, taken from queue or from created
+        int creator;               // step that created the event, -1 if it was in queue
+        bool valid;                // the event was processed, not discarded
+        std::size_t saved;         // size of saved before the step
+        std::size_t crossings;     // size of crossings before the step
+        std::int64_t predictions;  // particles predicted by the step
+        std::int64_t inserts;      // events created by the step
+    };
+
+    // An event created in the current window, and the step that created it
+    struct Created {
+        Event event;
+        int creator;
+    };
+
+    // A particle and its prediction horizon before a step changed them
+    struct Saved {
+        int i;
+        Particle particle;
+        double horizon;
+    };
+
+    int index = 0;              // regions are numbered from left to right
+    int firstInterior = 0;      // the columns firstInterior <= x < lastInterior are not
+    int lastInterior = 0;       // next to another region
+    EventQueue queue;           // events whose particle a is in the region
+    Worker worker;              // scratch space of the predictions of the region
+    Statistics statistics;      // counters of the current window
+    double lastTime = 0.0;      // time of the last valid event committed
+    std::size_t processed = 0;  // events processed by the last window, kept or undone
+
+    std::vector<Step> steps;                    // events of the window, in order
+    std::vector<Created> created;               // heap of the events created, earliest first
+    std::vector<Saved> saved;                   // particles before the steps changed them
+    std::vector<CellGrid::Crossing> crossings;  // cell crossings of the steps
+    std::vector<Event> events;                  // events created by the current step
+
+    bool isInterior(int x) const { return x >= firstInterior && x < lastInterior; }
+
+    void save(int i, const Particle& particle, double horizon) {
+        saved.push_back({i, particle, horizon});
+    }
+
+    // Heap order of created: the earliest event on top
+    static bool later(const Created& x, const Created& y) { return y.event < x.event; }
+};
+
+/**
+ * The state shared by the regions during a window
+ */
+struct CollisionSystem::Window {
+    Window(double end, double simulationTime) : end{end}, simulationTime{simulationTime} {}
+
+    /**
+     * Make e the stop of the window if it is earlier than the current stop
+     */
+    void stopAt(const Event& e) {
+        std::lock_guard lock{mutex};
+        if (!stop || e < *stop) {
+            stop = e;
+            stopTime.store(e.scheduledTime(), std::memory_order_relaxed);
+        }
+    }
+
+    const double end;             // the window processes the events before end
+    const double simulationTime;  // the end of the simulation
+
+    std::optional<Event> stop;  // earliest event that stopped a region, later ones are undone
+    std::mutex mutex;           // protects stop
+
+    // time of stop, the regions read it without the lock to stop early
+    std::atomic<double> stopTime{std::numeric_limits<double>::infinity()};
+};
+
 /**
  * Constructor to create a system with the specified collection of particles
  * The individual particles will be mutated during the simulation
@@ -30,78 +222,1126 @@ CollisionSystem::CollisionSystem(std::vector<Particle> particles)
     : particles_{std::move(particles)} {}
 
 /**
- * Update priority queue with all new events for particle
+ * Constructor to restart a simulation from a checkpoint
+ * The queue is not part of the checkpoint: simulate predicts the events of all particles
+ * anew, as at the start of a simulation
  */
-void CollisionSystem::predict(PriorityQueue<Event>& queue, Particle& particle, double currentTime,
-                              double simulationTime) {
+CollisionSystem::CollisionSystem(Checkpoint checkpoint)
+    : particles_{std::move(checkpoint.particles)}, time_{checkpoint.time} {}
+
+/**
+ * Call f(j, dt) for every particle j that particle i may collide with, dt is the amount of
+ * time for them to collide (infinity if they do not), particle i must be at currentTime
+ * The particles are only read, so that several threads may call it at once
+ */
+template <class Function>
+void CollisionSystem::forCandidates(int i, double currentTime, std::vector<double>& times,
+                                    Function f) const {
+    if (broadPhase == BroadPhase::Grid) {
+        const Particle& particle = particles_[i];
+        grid_.forNeighbours(i, [&](int j) {
+            Particle that = particles_[j];
+            that.moveTo(currentTime);
+            f(j, particle.timeToHit(that));
+        });
+    } else {
+        forCandidates(i, currentTime, 0, static_cast<int>(std::ssize(particles_)), times, f);
+    }
+}
+
+/**
+ * Call f(j, dt) for the particles first <= j < last, j != i, with one vectorised pass over
+ * their trajectories
+ */
+template <class Function>
+void CollisionSystem::forCandidates(int i, double currentTime, int first, int last,
+                                    std::vector<double>& times, Function f) const {
+    times.resize(particles_.size());
+    store_.timesToHit(particles_[i], currentTime, first, last, times);
+    for (int j = first; j < last; ++j) {
+        if (j != i) f(j, times[j]);
+    }
+}
+
+/**
+ * Add all new events for particle i within the prediction horizon to events, to be inserted
+ * in the priority queue
+ * Particle i must be at currentTime
+ */
+void CollisionSystem::predict(std::vector<Event>& events, int i, double currentTime,
+                              double simulationTime, Worker& worker) {
+    const double horizon = std::min(currentTime + predictionHorizon, simulationTime);
+
     // particle-particle collisions
-    for (auto& p : particles_) {
-        const double dt = particle.timeToHit(p);
-        addEvent(currentTime + dt, &particle, &p, queue, simulationTime);
+    worker.truncated = false;
+    forCandidates(i, currentTime, worker.times, [&](int j, double dt) {
+        addPrediction(Event{currentTime + dt, Event::Type::Collision, particles_, i, j}, events,
+                      horizon, simulationTime, worker.truncated);
+    });
+
+    predictWalls(events, i, currentTime, simulationTime, worker.truncated);
+}
+
+/**
+ * Add the events of particle i with the walls and the cell grid to events
+ * If truncated, or if one of these events is beyond the prediction horizon, a Horizon event
+ * predicts particle i again at the horizon
+ */
+void CollisionSystem::predictWalls(std::vector<Event>& events, int i, double currentTime,
+                                   double simulationTime, bool truncated) {
+    const Particle& particle = particles_[i];
+    const double horizon = std::min(currentTime + predictionHorizon, simulationTime);
+
+    // particle-wall collisions
+    const double dtX = particle.timeToHitVerticalWall();
+    addPrediction(Event{currentTime + dtX, Event::Type::VerticalWall, particles_, i}, events,
+                  horizon, simulationTime, truncated);
+
+    const double dtY = particle.timeToHitHorizontalWall();
+    addPrediction(Event{currentTime + dtY, Event::Type::HorizontalWall, particles_, i}, events,
+                  horizon, simulationTime, truncated);
+
+    // crossing into another cell
+    if (broadPhase == BroadPhase::Grid) {
+        const double dtC = grid_.timeToCross(i, particle);
+        addPrediction(Event{currentTime + dtC, Event::Type::CellCrossing, particles_, i}, events,
+                      horizon, simulationTime, truncated);
+    }
+
+    // the earlier events of particle i are done or invalid, and so is its Horizon event
+    if (truncated) {
+        events.push_back(Event{horizon, Event::Type::Horizon, particles_, i});
+        horizons_[i] = horizon;
+    } else {
+        horizons_[i] = std::numeric_limits<double>::infinity();
+    }
+}
+
+/**
+ * Add all new events for the particles in indices to events, in the order of indices
+ * Each thread collects its events in its own buffer and the buffers are appended in thread
+ * order, so the events are the same, in the same order, for any number of threads
+ */
+void CollisionSystem::predict(std::vector<Event>& events, std::span<const int> indices,
+                              double currentTime, double simulationTime) {
+    {
+        ScopedTimer timer{timing, statistics_.moveSeconds};
+        for (int i : indices) {
+            particles_[i].moveTo(currentTime);
+        }
+    }
+
+    ScopedTimer timer{timing, statistics_.predictSeconds};
+    statistics_.predictions += std::ssize(indices);
+
+    const auto gather = [&] {
+        for (auto& worker : workers_) {
+            events.insert(events.end(), worker.events.begin(), worker.events.end());
+            worker.events.clear();
+        }
+    };
+
+    if (pool_->size() > 1 && std::ssize(indices) >= parallel_particles) {
+        // one range of particles per thread
+        pool_->parallelFor(static_cast<int>(std::ssize(indices)), [&](int t, int first, int last) {
+            for (int k = first; k < last; ++k) {
+                predict(workers_[t].events, indices[k], currentTime, simulationTime, workers_[t]);
+            }
+        });
+        gather();
+    } else if (pool_->size() > 1 && broadPhase == BroadPhase::AllPairs &&
+               std::ssize(particles_) >= parallel_candidates) {
+        // one range of candidates per thread
+        const double horizon = std::min(currentTime + predictionHorizon, simulationTime);
+        for (int i : indices) {
+            const auto scan = [&](int t, int first, int last) {
+                Worker& worker = workers_[t];
+                worker.truncated = false;
+                forCandidates(i, currentTime, first, last, worker.times, [&](int j, double dt) {
+                    addPrediction(
+                        Event{currentTime + dt, Event::Type::Collision, particles_, i, j},
+                        worker.events, horizon, simulationTime, worker.truncated);
+                });
+            };
+            pool_->parallelFor(static_cast<int>(std::ssize(particles_)), scan);
+            gather();
+
+            const bool truncated = std::ranges::any_of(
+                workers_, [](const Worker& worker) { return worker.truncated; });
+            predictWalls(events, i, currentTime, simulationTime, truncated);
+        }
+    } else {
+        for (int i : indices) {
+            predict(events, i, currentTime, simulationTime, workers_[0]);
+        }
     }
+}
+
+/**
+ * Return the earliest event of particle i, possibly later than simulationTime
+ * Particle i must be at currentTime
+ */
+Event CollisionSystem::earliestEvent(int i, double currentTime, Worker& worker) {
+    // particle-particle collisions
+    double dt = std::numeric_limits<double>::infinity();
+    int other = Event::none;
+    forCandidates(i, currentTime, worker.times, [&](int j, double dtP) {
+        if (dtP < dt) {
+            dt = dtP;
+            other = j;
+        }
+    });
+
+    return earliestEvent(i, currentTime, dt, other);
+}
+
+/**
+ * Return the earliest event of particle i, among its collision with other in dt and its
+ * events with the walls and the cell grid
+ */
+Event CollisionSystem::earliestEvent(int i, double currentTime, double dt, int other) const {
+    const Particle& particle = particles_[i];
+    Event::Type type = Event::Type::Collision;
 
     // particle-wall collisions
     const double dtX = particle.timeToHitVerticalWall();
-    addEvent(currentTime + dtX, &particle, nullptr, queue, simulationTime);
+    if (dtX < dt) {
+        dt = dtX;
+        type = Event::Type::VerticalWall;
+        other = Event::none;
+    }
 
     const double dtY = particle.timeToHitHorizontalWall();
-    addEvent(currentTime + dtY, nullptr, &particle, queue, simulationTime);
+    if (dtY < dt) {
+        dt = dtY;
+        type = Event::Type::HorizontalWall;
+        other = Event::none;
+    }
+
+    // crossing into another cell
+    if (broadPhase == BroadPhase::Grid) {
+        const double dtC = grid_.timeToCross(i, particle);
+        if (dtC < dt) {
+            dt = dtC;
+            type = Event::Type::CellCrossing;
+            other = Event::none;
+        }
+    }
+
+    return Event{currentTime + dt, type, particles_, i, other};
+}
+
+/**
+ * Update the entries of the particles in indices in the indexed queue with their earliest
+ * events
+ * The events are predicted in parallel and the queue is updated by the calling thread, in the
+ * order of indices. When the candidates are split, the earliest collisions of the threads are
+ * compared in thread order, so that ties are broken as in a sequential scan.
+ */
+void CollisionSystem::predict(IndexedPriorityQueue<Event>& queue, std::span<const int> indices,
+                              double currentTime, double simulationTime) {
+    {
+        ScopedTimer timer{timing, statistics_.moveSeconds};
+        for (int i : indices) {
+            particles_[i].moveTo(currentTime);
+        }
+    }
+
+    std::vector<Event>& earliest = earliest_;
+    earliest.resize(indices.size());
+
+    {
+        ScopedTimer timer{timing, statistics_.predictSeconds};
+        statistics_.predictions += std::ssize(indices);
+
+        if (pool_->size() > 1 && std::ssize(indices) >= parallel_particles) {
+            // one range of particles per thread
+            const auto scan = [&](int t, int first, int last) {
+                for (int k = first; k < last; ++k) {
+                    earliest[k] = earliestEvent(indices[k], currentTime, workers_[t]);
+                }
+            };
+            pool_->parallelFor(static_cast<int>(std::ssize(indices)), scan);
+        } else if (pool_->size() > 1 && broadPhase == BroadPhase::AllPairs &&
+                   std::ssize(particles_) >= parallel_candidates) {
+            // one range of candidates per thread
+            for (std::size_t k = 0; k < indices.size(); ++k) {
+                const int i = indices[k];
+                for (auto& worker : workers_) {
+                    worker.dt = std::numeric_limits<double>::infinity();
+                    worker.other = Event::none;
+                }
+                const auto scan = [&](int t, int first, int last) {
+                    Worker& worker = workers_[t];
+                    forCandidates(i, currentTime, first, last, worker.times,
+                                  [&](int j, double dtP) {
+                                      if (dtP < worker.dt) {
+                                          worker.dt = dtP;
+                                          worker.other = j;
+                                      }
+                                  });
+                };
+                pool_->parallelFor(static_cast<int>(std::ssize(particles_)), scan);
+
+                double dt = std::numeric_limits<double>::infinity();
+                int other = Event::none;
+                for (const auto& worker : workers_) {
+                    if (worker.dt < dt) {
+                        dt = worker.dt;
+                        other = worker.other;
+                    }
+                }
+                earliest[k] = earliestEvent(i, currentTime, dt, other);
+            }
+        } else {
+            for (std::size_t k = 0; k < indices.size(); ++k) {
+                earliest[k] = earliestEvent(indices[k], currentTime, workers_[0]);
+            }
+        }
+    }
+
+    ScopedTimer timer{timing, statistics_.queueSeconds};
+    for (std::size_t k = 0; k < indices.size(); ++k) {
+        updateEvent(indices[k], earliest[k], queue, dependents_, simulationTime);
+    }
+    statistics_.queueInserts += std::ssize(indices);
+    statistics_.peakQueueSize = std::max(statistics_.peakQueueSize, queue.size());
 }
 
 void CollisionSystem::simulate(double simulationTime, double drawFrequenzy) {
-    PriorityQueue<Event> queue;  // the priority queue
-    double currentTime = 0.0;    // initialize simulation clock time
+    // the simulation clock starts at time_ with the particles at their current positions
+    for (auto& p : particles_) {
+        p.time = time_;
+    }
+    store_.assign(particles_);
+    statistics_ = {.startTime = time_, .simulatedTime = time_};
+    nextReport_ = nextMultiple(time_, reportInterval);
+    nextCheckpoint_ = nextMultiple(time_, checkpointInterval);
+    nextTrace_ = nextMultiple(time_, traceInterval);
+    start_ = std::chrono::steady_clock::now();
+
+    if (!pool_ || pool_->size() != std::max(threads, 1)) {
+        pool_ = std::make_unique<ThreadPool>(threads);
+        workers_.resize(pool_->size());
+    }
+
+    statistics_.timed = timing;
+    if (scheduling == Scheduling::Indexed) {
+        simulateIndexed(simulationTime, drawFrequenzy);
+    } else if (scheduling == Scheduling::Regions && broadPhase == BroadPhase::Grid) {
+        statistics_.windowed = true;
+        simulateRegions(simulationTime, drawFrequenzy);
+    } else {
+        statistics_.compacting = compactionThreshold < 1.0;
+        simulateLazy(simulationTime, drawFrequenzy);
+    }
+    statistics_.wallSeconds = elapsedSeconds();
+}
+
+/**
+ * Wall-clock time since the start of simulate
+ */
+double CollisionSystem::elapsedSeconds() const {
+    const auto now = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(now - start_).count();
+}
+
+/**
+ * Count an event at currentTime and call reportCallback if a report is due
+ */
+void CollisionSystem::countEvent(double currentTime) {
+    ++statistics_.events;
+    statistics_.simulatedTime = currentTime;
+    report(currentTime);
+}
+
+/**
+ * Call reportCallback if a report is due at currentTime
+ */
+void CollisionSystem::report(double currentTime) {
+    if (reportCallback && reportInterval > 0.0 && currentTime >= nextReport_) {
+        statistics_.wallSeconds = elapsedSeconds();
+        reportCallback(statistics_);
+        nextReport_ = nextMultiple(currentTime, reportInterval);
+    }
+}
+
+/**
+ * Call checkpointCallback if a checkpoint is due
+ * All events before currentTime are done, the particles are copied and the copies moved to
+ * currentTime, so that the simulation itself is not changed by checkpoints
+ */
+void CollisionSystem::checkpoint(double currentTime) {
+    if (!checkpointCallback || checkpointInterval <= 0.0 || currentTime < nextCheckpoint_) {
+        return;
+    }
+
+    std::vector<Particle> copies = particles_;
+    for (auto& p : copies) {
+        p.moveTo(currentTime);
+    }
+    checkpointCallback(std::move(copies), currentTime);
+    nextCheckpoint_ = nextMultiple(currentTime, checkpointInterval);
+}
+
+/**
+ * Call traceCallback for each multiple of traceInterval up to time
+ * All events before time are done and the particles are hashed as if they were moved to the
+ * multiple. The trace only depends on the collisions, not on the times of the other events
+ */
+void CollisionSystem::trace(double time) {
+    if (!traceCallback || traceInterval <= 0.0) {
+        return;
+    }
+
+    while (nextTrace_ <= time) {
+        traceCallback(nextTrace_, hash_particles(particles_, nextTrace_));
+        // nextTrace_ / traceInterval may round down to the previous multiple
+        nextTrace_ = nextMultiple(nextTrace_ + 0.5 * traceInterval, traceInterval);
+    }
+}
+
+/**
+ * Call renderCallback with the particles at currentTime
+ * In deterministic mode the particles are copied, so that rendering does not change them
+ */
+void CollisionSystem::render(double currentTime) {
+    if (!renderCallback) {
+        return;
+    }
 
-    // add first redraw event to the queue
-    addEvent(0.0, nullptr, nullptr, queue, simulationTime);
+    if (deterministic) {
+        copies_ = particles_;
+        for (auto& p : copies_) {
+            p.moveTo(currentTime);
+        }
+        renderCallback(copies_);
+    } else {
+        moveAllTo(currentTime);
+        renderCallback(particles_);
+    }
+}
+
+/**
+ * Move all particles to their positions at time
+ */
+void CollisionSystem::moveAllTo(double time) {
+    ScopedTimer timer{timing, statistics_.moveSeconds};
+    for (auto& p : particles_) {
+        p.moveTo(time);
+    }
+}
+
+/**
+ * Process event e at its time: update the velocities of its particles and add their new events
+ * to events
+ * In a window of region, the statistics are those of the region, the particles are predicted by
+ * the calling thread and every particle and cell changed is logged in region
+ */
+void CollisionSystem::processEvent(const Event& e, std::vector<Event>& events,
+                                   double simulationTime, Region* region) {
+    Statistics& statistics = region ? region->statistics : statistics_;
+    const int a = e.particleA();  // index of particle A
+    const int b = e.particleB();  // index of particle B
+    const double currentTime = e.scheduledTime();
+
+    // save the particles before they change, in a window
+    const auto save = [&](int i) {
+        if (region && i != Event::none) region->save(i, particles_[i], horizons_[i]);
+    };
+    save(a);
+    save(b);
 
-    // add all possible collisions of particle with other particles and walls to the queue
-    for (auto& particle : particles_) {
-        predict(queue, particle, currentTime, simulationTime);
+    // update positions of the particles involved, the others are moved when needed
+    {
+        ScopedTimer timer{timing, statistics.moveSeconds};
+        particles_[a].moveTo(currentTime);
+        if (b != Event::none) particles_[b].moveTo(currentTime);
     }
 
+    // predict the particles, by the calling thread in a window
+    const auto predictEvents = [&](std::span<const int> indices) {
+        if (!region) {
+            predict(events, indices, currentTime, simulationTime);
+            return;
+        }
+        ScopedTimer timer{timing, statistics.predictSeconds};
+        statistics.predictions += std::ssize(indices);
+        for (int i : indices) {
+            predict(events, i, currentTime, simulationTime, region->worker);
+        }
+    };
+
+    // process event: update velocity, if needed
+    if (e.type() == Event::Type::Collision) {
+        particles_[a].bounceOff(particles_[b]);  // particle-particle collision
+        updateTrajectory(a);
+        updateTrajectory(b);
+        predictEvents(std::array{a, b});
+    } else if (e.type() == Event::Type::VerticalWall) {
+        particles_[a].bounceOffVerticalWall();  // particle-vertical wall collision
+        updateTrajectory(a);
+        predictEvents(std::array{a});
+    } else if (e.type() == Event::Type::HorizontalWall) {
+        particles_[a].bounceOffHorizontalWall();  // particle-horizontal wall collision
+        updateTrajectory(a);
+        predictEvents(std::array{a});
+    } else if (e.type() == Event::Type::CellCrossing) {
+        // add the collisions with the particles that became neighbours
+        ScopedTimer timer{timing, statistics.predictSeconds};
+        ++statistics.predictions;
+
+        // a pending Horizon event of a predicts all its events from its time, so they are
+        // not added twice
+        const double horizon =
+            std::min({currentTime + predictionHorizon, simulationTime, horizons_[a]});
+        bool truncated = false;
+        const auto crossing = grid_.cross(a, particles_[a], [&](int j) {
+            save(j);
+            particles_[j].moveTo(currentTime);
+            const double dt = particles_[a].timeToHit(particles_[j]);
+            addPrediction(Event{currentTime + dt, Event::Type::Collision, particles_, a, j},
+                          events, horizon, simulationTime, truncated);
+        });
+        if (region) region->crossings.push_back(crossing);
+
+        const double dtC = grid_.timeToCross(a, particles_[a]);
+        addPrediction(Event{currentTime + dtC, Event::Type::CellCrossing, particles_, a},
+                      events, horizon, simulationTime, truncated);
+
+        if (truncated && horizons_[a] == std::numeric_limits<double>::infinity()) {
+            events.push_back(Event{horizon, Event::Type::Horizon, particles_, a});
+            horizons_[a] = horizon;
+        }
+    } else if (e.type() == Event::Type::Horizon) {
+        // the events of a beyond its last prediction horizon were left out
+        predictEvents(std::array{a});
+    }
+}
+
+void CollisionSystem::simulateLazy(double simulationTime, double drawFrequenzy) {
+    EventQueue queue;           // the priority queue
+    std::vector<Event> events;  // new events, not yet added to the queue
+    double currentTime = time_;  // initialize simulation clock time
+
+    // insert the new events in the queue
+    const auto insertEvents = [&] {
+        ScopedTimer timer{timing, statistics_.queueSeconds};
+        for (const Event& e : events) {
+            if (e.particleA() != Event::none) ++queuedA_[e.particleA()];
+        }
+        statistics_.queueInserts += std::ssize(events);
+        queue.insertBatch(events);
+        events.clear();
+        statistics_.peakQueueSize = std::max(statistics_.peakQueueSize, queue.size());
+    };
+
+    // remove the invalidated events from the queue, once they are a large part of it
+    // invalidated_ only counts the events whose particle a collided, a lower bound
+    const auto compact = [&] {
+        if (queue.size() < min_compaction_size ||
+            invalidated_ <= compactionThreshold * static_cast<double>(queue.size())) {
+            return;
+        }
+
+        ScopedTimer timer{timing, statistics_.queueSeconds};
+        std::ranges::fill(queuedA_, 0);
+        const std::size_t removed = queue.removeIf([&](const Event& e) {
+            if (!e.isValid(particles_)) return true;
+            if (e.particleA() != Event::none) ++queuedA_[e.particleA()];
+            return false;
+        });
+        invalidated_ = 0;
+        ++statistics_.compactions;
+        statistics_.compacted += removed;
+    };
+
+    if (broadPhase == BroadPhase::Grid) {
+        grid_.build(particles_);
+    }
+    horizons_.assign(particles_.size(), std::numeric_limits<double>::infinity());
+    queuedA_.assign(particles_.size(), 0);
+    invalidated_ = 0;
+
+    // add first redraw event to the queue, unless the simulation is not rendered
+    if (drawFrequenzy > 0.0) {
+        addEvent(Event{currentTime}, events, simulationTime);
+    }
+
+    // add all possible collisions of particle with other particles and walls to the queue,
+    // as one batch so that the queue can be built in linear time
+    std::vector<int> indices(particles_.size());
+    std::iota(indices.begin(), indices.end(), 0);
+    predict(events, indices, currentTime, simulationTime);
+    insertEvents();
+
     // the main event-driven simulation loop
     while (!queue.isEmpty()) {
+        checkpoint(currentTime);
+
         // get impending event, discard if invalidated
-        const Event e = queue.deleteMin();
-        if (!e.isValid()) {
+        const Event e = [&] {
+            ScopedTimer timer{timing, statistics_.queueSeconds};
+            return queue.deleteMin();
+        }();
+        ++statistics_.queueRemovals;
+        if (e.hasCollidedA(particles_)) {
+            --invalidated_;
+        } else if (e.particleA() != Event::none) {
+            --queuedA_[e.particleA()];
+        }
+        if (!e.isValid(particles_)) {
+            ++statistics_.invalidated;
             continue;
         }
 
-        Particle* particleA = e.particleA;  // pointer to particle A
-        Particle* particleB = e.particleB;  // pointer to particle B
+        currentTime = e.scheduledTime();  // update simulation clock
+        trace(currentTime);
+        countEvent(currentTime);
+
+        if (e.type() == Event::Type::Render) {
+            render(currentTime);
+
+            // add another rendering event to the queue
+            addEvent(Event{currentTime + 1.0 / drawFrequenzy}, events, simulationTime);
+
+            // in case user closes the simulation window
+            if (abortCallback && abortCallback()) break;
+        } else {
+            processEvent(e, events, simulationTime, nullptr);
 
-        // update particles positions
-        for (auto& p : particles_) {
-            p.move(e.time - currentTime);
+            // the queued events of the particles that collided are invalid
+            if (e.type() != Event::Type::CellCrossing && e.type() != Event::Type::Horizon) {
+                countInvalidated(e.particleA());
+                if (e.particleB() != Event::none) countInvalidated(e.particleB());
+            }
         }
-        currentTime = e.time;  // update simulation clock
 
-        // process event: update velocity, if needed
-        if (particleA != nullptr && particleB != nullptr) {
-            particleA->bounceOff(*particleB);  // particle-particle collision
-            predict(queue, *particleA, currentTime, simulationTime);
-            predict(queue, *particleB, currentTime, simulationTime);
-        } else if (particleA != nullptr && particleB == nullptr) {
-            particleA->bounceOffVerticalWall();  // particle-horizontal wall collision
-            predict(queue, *particleA, currentTime, simulationTime);
-        } else if (particleA == nullptr && particleB != nullptr) {
-            particleB->bounceOffHorizontalWall();  // particle-vertical wall collision
-            predict(queue, *particleB, currentTime, simulationTime);
-        } else if (particleA == nullptr && particleB == nullptr) {
-            renderCallback(particles_);
+        insertEvents();
+        compact();
+    }
 
-            // add another rendering event to the queue
-            addEvent(currentTime + 1.0 / drawFrequenzy, nullptr, nullptr, queue, simulationTime);
+    // no events are left before simulationTime, unless the simulation was aborted
+    if (queue.isEmpty()) trace(simulationTime);
+
+    moveAllTo(currentTime);
+    time_ = currentTime;
+}
+
+/**
+ * Event loop of region scheduling
+ * The regions are vertical strips of the cell grid. The loop alternates between windows, in
+ * which the regions process their events in parallel, and the events at the boundaries between
+ * regions, which are processed alone. A window ends at the earliest event that stopped a
+ * region: the events after it are undone, so that every event is processed in the same state
+ * as in simulateLazy
+ */
+void CollisionSystem::simulateRegions(double simulationTime, double drawFrequenzy) {
+    const int n = static_cast<int>(std::ssize(particles_));
+    double currentTime = time_;  // initialize simulation clock time
+    bool aborted = false;
+
+    grid_.build(particles_);
+    horizons_.assign(n, std::numeric_limits<double>::infinity());
+
+    // strips of at least min_region_columns columns
+    const int m = grid_.resolution();
+    const int count = std::clamp(regions > 0 ? regions : pool_->size(), 1,
+                                 std::max(1, m / min_region_columns));
+    std::vector<Region> strips(count);
+    std::vector<int> regionOf(m);  // region of each column
+    for (int r = 0; r < count; ++r) {
+        const int first = r * m / count;
+        const int last = (r + 1) * m / count;
+        strips[r].index = r;
+        strips[r].firstInterior = r > 0 ? first + 1 : first;
+        strips[r].lastInterior = r + 1 < count ? last - 1 : last;
+        std::fill(regionOf.begin() + first, regionOf.begin() + last, r);
+    }
+
+    owner_.resize(n);
+    counts_.resize(n);
+    for (int i = 0; i < n; ++i) {
+        owner_[i] = regionOf[grid_.column(i)];
+        counts_[i] = particles_[i].counter();
+    }
+
+    // insert the new events in the queues of the regions of their particles a
+    std::vector<Event> events;  // new events, not yet added to the queues
+    const auto insertEvents = [&] {
+        ScopedTimer timer{timing, statistics_.queueSeconds};
+        statistics_.queueInserts += std::ssize(events);
+        for (const Event& e : events) {
+            strips[owner_[e.particleA()]].events.push_back(e);
+        }
+        events.clear();
+        for (auto& region : strips) {
+            region.queue.insertBatch(region.events);
+            region.events.clear();
+        }
+    };
+
+    // the queues grow in windows, their sizes are taken between windows
+    const auto countQueued = [&] {
+        std::size_t size = 0;
+        for (const auto& region : strips) {
+            size += region.queue.size();
+        }
+        statistics_.peakQueueSize = std::max(statistics_.peakQueueSize, size);
+    };
+
+    // add the counters of the windows of the regions to the counters of the simulation
+    const auto gatherStatistics = [&] {
+        for (auto& region : strips) {
+            Statistics& window = region.statistics;
+            statistics_.events += window.events;
+            statistics_.invalidated += window.invalidated;
+            statistics_.predictions += window.predictions;
+            statistics_.queueInserts += window.queueInserts;
+            statistics_.queueRemovals += window.queueRemovals;
+            statistics_.undone += window.undone;
+            statistics_.predictSeconds += window.predictSeconds;
+            statistics_.queueSeconds += window.queueSeconds;
+            statistics_.moveSeconds += window.moveSeconds;
+            window = {};
+            currentTime = std::max(currentTime, region.lastTime);
+        }
+        ++statistics_.windows;
+        statistics_.simulatedTime = currentTime;
+    };
+
+    // add all possible collisions of particle with other particles and walls to the queues,
+    // as one batch so that the queues can be built in linear time
+    std::vector<int> indices(n);
+    std::iota(indices.begin(), indices.end(), 0);
+    predict(events, indices, currentTime, simulationTime);
+    insertEvents();
+    countQueued();
+
+    // the rate of the events that stop a window, estimated from the windows so far
+    std::int64_t stops = 0;  // windows that ended at a stop
+    double span = 0.0;       // simulated time covered by the windows
+
+    // the rendering events are not queued, the windows end at them
+    double nextRender = drawFrequenzy > 0.0 ? currentTime
+                                            : std::numeric_limits<double>::infinity();
+
+    // the main event-driven simulation loop
+    while (true) {
+        checkpoint(currentTime);
+
+        // the region of the impending event
+        Region* front = nullptr;
+        for (auto& region : strips) {
+            if (!region.queue.isEmpty() &&
+                (!front || region.queue.findMin() < front->queue.findMin())) {
+                front = &region;
+            }
+        }
+
+        if (nextRender < simulationTime &&
+            (!front || !(front->queue.findMin().scheduledTime() < nextRender))) {
+            currentTime = nextRender;
+            trace(currentTime);
+            countEvent(currentTime);
+            render(currentTime);
+            nextRender = currentTime + 1.0 / drawFrequenzy;
+
+            // in case user closes the simulation window
+            if (abortCallback && abortCallback()) {
+                aborted = true;
+                break;
+            }
+            continue;
+        }
+        if (!front) break;
+
+        const Event e = front->queue.findMin();
+        trace(e.scheduledTime());
+
+        if (access(e, *front) == Access::Process) {
+            // the window ends at the next rendering or trace, which need the particles at their
+            // time, checkpoints and reports are taken between windows at any time
+            // otherwise at a fraction of the mean time between stops, so that little is undone
+            const double start = e.scheduledTime();
+            double end = std::min(nextRender, simulationTime);
+            if (traceCallback && traceInterval > 0.0) end = std::min(end, nextTrace_);
+            if (stops > 0) end = std::min(end, start + window_length * span / stops);
+
+            Window window{end, simulationTime};
+            pool_->parallelFor(count, [&](int, int first, int last) {
+                for (int r = first; r < last; ++r) simulateWindow(strips[r], window);
+            });
+            pool_->parallelFor(count, [&](int, int first, int last) {
+                for (int r = first; r < last; ++r) commitWindow(strips[r], window);
+            });
+
+            // with a thread per region the window lasts as long as its busiest region
+            std::size_t processed = 0;
+            for (const auto& region : strips) {
+                processed = std::max(processed, region.processed);
+            }
+            statistics_.criticalPath += processed;
+
+            if (window.stop) {
+                ++stops;
+                span += window.stop->scheduledTime() - start;
+            } else {
+                span += end - start;
+            }
+
+            gatherStatistics();
+            countQueued();
+            report(currentTime);
+            continue;
+        }
+
+        // an event at a boundary between regions is processed alone, discard if invalidated
+        {
+            ScopedTimer timer{timing, statistics_.queueSeconds};
+            front->queue.deleteMin();
+        }
+        ++statistics_.queueRemovals;
+        ++statistics_.criticalPath;
+        if (!e.isValid(particles_)) {
+            ++statistics_.invalidated;
+            continue;
+        }
+
+        currentTime = e.scheduledTime();  // update simulation clock
+        countEvent(currentTime);
+        processEvent(e, events, simulationTime, nullptr);
+
+        // a crossing may move particle a to another region
+        const int a = e.particleA();
+        const int b = e.particleB();
+        owner_[a] = regionOf[grid_.column(a)];
+        counts_[a] = particles_[a].counter();
+        if (b != Event::none) counts_[b] = particles_[b].counter();
+
+        insertEvents();
+        countQueued();
+    }
 
-            // fmt::print("Simulation Time: {:8.3f}, Queue Size: {:10}\n", currentTime, queue.size());
+    // no events are left before simulationTime, unless the simulation was aborted
+    if (!aborted) trace(simulationTime);
 
-           if (abortCallback()) break; // in case user closes the simulation window
+    moveAllTo(currentTime);
+    time_ = currentTime;
+}
+
+/**
+ * What region does with e in a window
+ * The particles of the other regions may change during the window, only their collision counts
+ * at its start are read: an event of such a particle is invalid if the particle collided
+ * before, otherwise the event is at a boundary
+ */
+CollisionSystem::Access CollisionSystem::access(const Event& e, const Region& region) const {
+    const int a = e.particleA();  // index of particle A
+    const int b = e.particleB();  // index of particle B
+
+    bool foreign = false;
+    for (int i : {a, b}) {
+        if (i == Event::none || owner_[i] == region.index) continue;
+        if (e.hasCollided(i, counts_[i])) return Access::Discard;
+        foreign = true;
+    }
+    if (foreign) return Access::Stop;
+    if (!e.isValid(particles_)) return Access::Discard;
+
+    // the particles in the boundary columns may interact with the neighbouring regions
+    if (!region.isInterior(grid_.column(a)) ||
+        (b != Event::none && !region.isInterior(grid_.column(b)))) {
+        return Access::Stop;
+    }
+    if (e.type() == Event::Type::CellCrossing) {
+        Particle p = particles_[a];
+        p.moveTo(e.scheduledTime());
+        if (!region.isInterior(grid_.nextColumn(a, p))) return Access::Stop;
+    }
+    return Access::Process;
+}
+
+/**
+ * Process the events of region before the end of window, in order, until an event at a
+ * boundary or one later than the stop of another region
+ * Each event is logged in region.steps with the particles it changed, the events it created
+ * are kept in region.created until the window is committed
+ */
+void CollisionSystem::simulateWindow(Region& region, Window& window) {
+    Statistics& statistics = region.statistics;
+
+    while (true) {
+        // the impending event, from the queue or created in the window
+        const bool created =
+            !region.created.empty() &&
+            (region.queue.isEmpty() || region.created.front().event < region.queue.findMin());
+        if (!created && region.queue.isEmpty()) break;
+
+        const Event e = created ? region.created.front().event : region.queue.findMin();
+        if (!(e.scheduledTime() < window.end) ||
+            e.scheduledTime() > window.stopTime.load(std::memory_order_relaxed)) {
+            break;
+        }
+
+        const Access access = this->access(e, region);
+        if (access == Access::Stop || region.steps.size() == max_window_events) {
+            window.stopAt(e);
+            break;
+        }
+
+        Region::Step step{.event = e,
+                          .creator = -1,
+                          .valid = access == Access::Process,
+                          .saved = region.saved.size(),
+                          .crossings = region.crossings.size(),
+                          .predictions = statistics.predictions,
+                          .inserts = 0};
+        {
+            ScopedTimer timer{timing, statistics.queueSeconds};
+            if (created) {
+                std::pop_heap(region.created.begin(), region.created.end(), Region::later);
+                step.creator = region.created.back().creator;
+                region.created.pop_back();
+            } else {
+                region.queue.deleteMin();
+            }
+        }
+        ++statistics.queueRemovals;
+
+        if (access == Access::Discard) {
+            ++statistics.invalidated;
+            step.predictions = 0;
+            region.steps.push_back(step);
+            continue;
+        }
+
+        ++statistics.events;
+        processEvent(e, region.events, window.simulationTime, &region);
+        step.predictions = statistics.predictions - step.predictions;
+        step.inserts = std::ssize(region.events);
+        statistics.queueInserts += step.inserts;
+
+        ScopedTimer timer{timing, statistics.queueSeconds};
+        const int creator = static_cast<int>(std::ssize(region.steps));
+        for (const Event& x : region.events) {
+            region.created.push_back({x, creator});
+            std::push_heap(region.created.begin(), region.created.end(), Region::later);
+        }
+        region.events.clear();
+        region.steps.push_back(step);
+    }
+}
+
+/**
+ * Undo the events of region later than the stop of window, the latest first, and queue the
+ * events created by the others
+ */
+void CollisionSystem::commitWindow(Region& region, const Window& window) {
+    Statistics& statistics = region.statistics;
+    auto& steps = region.steps;
+
+    region.processed = steps.size();
+    std::size_t kept = steps.size();
+    while (kept > 0 && window.stop && *window.stop < steps[kept - 1].event) {
+        --kept;
+    }
+
+    for (std::size_t k = steps.size(); k-- > kept;) {
+        const Region::Step& step = steps[k];
+        while (region.saved.size() > step.saved) {
+            const Region::Saved& saved = region.saved.back();
+            particles_[saved.i] = saved.particle;
+            horizons_[saved.i] = saved.horizon;
+            updateTrajectory(saved.i);
+            region.saved.pop_back();
+        }
+        while (region.crossings.size() > step.crossings) {
+            grid_.undo(region.crossings.back());
+            region.crossings.pop_back();
+        }
+
+        statistics.events -= step.valid ? 1 : 0;
+        statistics.invalidated -= step.valid ? 0 : 1;
+        statistics.predictions -= step.predictions;
+        statistics.queueInserts -= step.inserts;
+        --statistics.queueRemovals;
+        ++statistics.undone;
+
+        // put the event back, unless the step that created it is undone too
+        if (step.creator < 0) {
+            region.queue.insert(step.event);
+        } else if (static_cast<std::size_t>(step.creator) < kept) {
+            region.created.push_back({step.event, step.creator});
+        }
+    }
+    std::erase_if(region.created, [&](const Region::Created& x) {
+        return static_cast<std::size_t>(x.creator) >= kept;
+    });
+
+    // the events before the stop are done
+    for (std::size_t k = 0; k < kept; ++k) {
+        if (steps[k].valid) region.lastTime = steps[k].event.scheduledTime();
+    }
+    for (const auto& saved : region.saved) {
+        counts_[saved.i] = particles_[saved.i].counter();
+    }
+
+    {
+        ScopedTimer timer{timing, statistics.queueSeconds};
+        for (const auto& x : region.created) {
+            region.events.push_back(x.event);
         }
+        region.queue.insertBatch(region.events);
     }
+    region.events.clear();
+    region.created.clear();
+    region.steps.clear();
+    region.saved.clear();
+    region.crossings.clear();
 }
 
- /**
+void CollisionSystem::simulateIndexed(double simulationTime, double drawFrequenzy) {
+    const int n = static_cast<int>(std::ssize(particles_));
+    const int renderHandle = n;  // handle of the rendering event, the particles use 0, ..., n-1
+
+    IndexedPriorityQueue<Event> queue(n + 1);  // the priority queue
+    double currentTime = time_;                 // initialize simulation clock time
+
+    if (broadPhase == BroadPhase::Grid) {
+        grid_.build(particles_);
+    }
+    dependents_.assign(n, {});
+
+    // add first redraw event to the queue, unless the simulation is not rendered
+    if (drawFrequenzy > 0.0) {
+        updateEvent(renderHandle, Event{currentTime}, queue, dependents_, simulationTime);
+    }
+
+    // add the earliest collision of each particle with other particles and walls to the queue
+    std::vector<int> indices(n);
+    std::iota(indices.begin(), indices.end(), 0);
+    predict(queue, indices, currentTime, simulationTime);
+
+    // the main event-driven simulation loop, all queued events are valid
+    while (!queue.isEmpty()) {
+        checkpoint(currentTime);
+
+        const int h = queue.findMin();
+        const Event e = queue.key(h);
+
+        const int a = e.particleA();  // index of particle A
+        const int b = e.particleB();  // index of particle B
+
+        currentTime = e.scheduledTime();  // update simulation clock
+        trace(currentTime);
+        countEvent(currentTime);
+
+        // update positions of the particles involved, the others are moved when needed
+        {
+            ScopedTimer timer{timing, statistics_.moveSeconds};
+            if (a != Event::none) particles_[a].moveTo(currentTime);
+            if (b != Event::none) particles_[b].moveTo(currentTime);
+        }
+
+        if (e.type() == Event::Type::Render) {
+            render(currentTime);
+
+            // move the rendering event to the next frame
+            updateEvent(renderHandle, Event{currentTime + 1.0 / drawFrequenzy}, queue,
+                        dependents_, simulationTime);
+
+            // in case user closes the simulation window
+            if (abortCallback && abortCallback()) break;
+            continue;
+        }
+
+        if (e.type() == Event::Type::CellCrossing) {
+            // the particle's earliest event may involve its new neighbours
+            grid_.cross(a, particles_[a], [](int) {});
+            predict(queue, std::array{a}, currentTime, simulationTime);
+            continue;
+        }
+
+        // process event: update velocity
+        if (e.type() == Event::Type::Collision) {
+            particles_[a].bounceOff(particles_[b]);  // particle-particle collision
+            updateTrajectory(a);
+            updateTrajectory(b);
+        } else if (e.type() == Event::Type::VerticalWall) {
+            particles_[a].bounceOffVerticalWall();  // particle-vertical wall collision
+            updateTrajectory(a);
+        } else {
+            particles_[a].bounceOffHorizontalWall();  // particle-horizontal wall collision
+            updateTrajectory(a);
+        }
+
+        // re-predict the particles involved and every particle whose event involves them,
+        // found in dependents_, in increasing order as a scan of the queue would
+        indices.clear();
+        for (int i : {a, b}) {
+            if (i == Event::none) continue;
+            indices.push_back(i);
+            indices.insert(indices.end(), dependents_[i].begin(), dependents_[i].end());
+        }
+        std::ranges::sort(indices);
+        const auto duplicates = std::ranges::unique(indices);
+        indices.erase(duplicates.begin(), duplicates.end());
+        predict(queue, indices, currentTime, simulationTime);
+    }
+
+    // no events are left before simulationTime, unless the simulation was aborted
+    if (queue.isEmpty()) trace(simulationTime);
+
+    moveAllTo(currentTime);
+    time_ = currentTime;
+}
+
+/**
+ * Return a multi-line report of the counters
+ */
+std::string CollisionSystem::Statistics::report() const {
+    const double perSecond = wallSeconds > 0.0 ? events / wallSeconds : 0.0;
+    const auto share = [&](double seconds) {
+        return wallSeconds > 0.0 ? 100.0 * seconds / wallSeconds : 0.0;
+    };
+
+    std::string s;
+    s += fmt::format("simulation time   {:.3f}\n", simulatedTime);
+    s += fmt::format("events            {} ({:.1f} per time unit, {:.0f}/s)\n", events,
+                     eventsPerTimeUnit(), perSecond);
+    s += fmt::format("invalidated       {}\n", invalidated);
+    s += fmt::format("predictions       {}\n", predictions);
+    s += fmt::format("queue inserts     {}\n", queueInserts);
+    s += fmt::format("queue removals    {}\n", queueRemovals);
+    if (compacting) {
+        s += fmt::format("compactions       {} ({} events removed)\n", compactions, compacted);
+    }
+    if (windowed) {
+        s += fmt::format("windows           {} optimistic ({} events rolled back)\n", windows,
+                         undone);
+        s += fmt::format("critical path     {} events ({:.2f}x speedup bound)\n", criticalPath,
+                         speedupBound());
+    }
+    s += fmt::format("peak queue size   {}\n", peakQueueSize);
+    s += fmt::format("wall-clock time   {:.3f} s\n", wallSeconds);
+    if (timed) {
+        s += fmt::format("  predict         {:.3f} s ({:.1f}%)\n", predictSeconds,
+                         share(predictSeconds));
+        s += fmt::format("  queue           {:.3f} s ({:.1f}%)\n", queueSeconds,
+                         share(queueSeconds));
+        s += fmt::format("  move            {:.3f} s ({:.1f}%)\n", moveSeconds,
+                         share(moveSeconds));
+    }
+    return s;
+}
+
+/**
+ * Counters of the last call to simulate, or of the running simulation
+ */
+const CollisionSystem::Statistics& CollisionSystem::statistics() const { return statistics_; }
+
+/**
  * Return a vector with all system particles
  */
 const std::vector<Particle>& CollisionSystem::particles() const { return particles_; }
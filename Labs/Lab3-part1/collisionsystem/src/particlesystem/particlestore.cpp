@@ -0,0 +1,112 @@
+#include <particlesystem/particlestore.h>
+
+#include <cassert>
+#include <cstddef>
+#include <limits>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace particlesystem {
+
+/**
+ * Replace the entries by the trajectories of particles
+ */
+void ParticleStore::assign(std::span<const Particle> particles) {
+    const std::size_t n = particles.size();
+    rx.resize(n);
+    ry.resize(n);
+    vx.resize(n);
+    vy.resize(n);
+    radius.resize(n);
+    t.resize(n);
+
+    for (std::size_t i = 0; i < n; ++i) {
+        update(static_cast<int>(i), particles[i]);
+    }
+}
+
+/**
+ * Set the trajectory of particle i to the trajectory of p
+ */
+void ParticleStore::update(int i, const Particle& p) {
+    assert(i >= 0 && i < size());
+    rx[i] = p.r.x;
+    ry[i] = p.r.y;
+    vx[i] = p.v.x;
+    vy[i] = p.v.y;
+    radius[i] = p.radius;
+    t[i] = p.time;
+}
+
+/**
+ * Compute out[j] = particle.timeToHit(that), for the entries first <= j < last, where that is
+ * particle j moved to time
+ * The vectorised loop evaluates the same expressions as Particle::timeToHit, in the same order
+ * and without fused multiply-add, so that the results are identical
+ */
+void ParticleStore::timesToHit(const Particle& particle, double time, int first, int last,
+                               std::span<double> out) const {
+    assert(std::ssize(out) == size());
+    assert(0 <= first && first <= last && last <= size());
+    const std::size_t n = static_cast<std::size_t>(last);
+    std::size_t j = static_cast<std::size_t>(first);
+
+#ifdef __AVX2__
+    const __m256d rX = _mm256_set1_pd(particle.r.x);
+    const __m256d rY = _mm256_set1_pd(particle.r.y);
+    const __m256d vX = _mm256_set1_pd(particle.v.x);
+    const __m256d vY = _mm256_set1_pd(particle.v.y);
+    const __m256d rad = _mm256_set1_pd(particle.radius);
+    const __m256d now = _mm256_set1_pd(time);
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d negate = _mm256_set1_pd(-0.0);  // flips the sign bit
+    const __m256d infinity = _mm256_set1_pd(std::numeric_limits<double>::infinity());
+
+    for (; j + 4 <= n; j += 4) {
+        // candidates moved to time
+        const __m256d dt = _mm256_sub_pd(now, _mm256_loadu_pd(&t[j]));
+        const __m256d thatVX = _mm256_loadu_pd(&vx[j]);
+        const __m256d thatVY = _mm256_loadu_pd(&vy[j]);
+        const __m256d thatRX = _mm256_add_pd(_mm256_loadu_pd(&rx[j]), _mm256_mul_pd(thatVX, dt));
+        const __m256d thatRY = _mm256_add_pd(_mm256_loadu_pd(&ry[j]), _mm256_mul_pd(thatVY, dt));
+
+        const __m256d drX = _mm256_sub_pd(thatRX, rX);
+        const __m256d drY = _mm256_sub_pd(thatRY, rY);
+        const __m256d dvX = _mm256_sub_pd(thatVX, vX);
+        const __m256d dvY = _mm256_sub_pd(thatVY, vY);
+
+        const __m256d dvdr = _mm256_add_pd(_mm256_mul_pd(drX, dvX), _mm256_mul_pd(drY, dvY));
+        const __m256d dvdv = _mm256_add_pd(_mm256_mul_pd(dvX, dvX), _mm256_mul_pd(dvY, dvY));
+        const __m256d drdr = _mm256_add_pd(_mm256_mul_pd(drX, drX), _mm256_mul_pd(drY, drY));
+        const __m256d sigma = _mm256_add_pd(rad, _mm256_loadu_pd(&radius[j]));
+        const __m256d sigma2 = _mm256_mul_pd(sigma, sigma);
+
+        const __m256d d = _mm256_sub_pd(_mm256_mul_pd(dvdr, dvdr),
+                                        _mm256_mul_pd(dvdv, _mm256_sub_pd(drdr, sigma2)));
+        const __m256d hit = _mm256_div_pd(
+            _mm256_xor_pd(_mm256_add_pd(dvdr, _mm256_sqrt_pd(d)), negate), dvdv);
+
+        // the cases where Particle::timeToHit returns infinity
+        __m256d miss = _mm256_cmp_pd(dvdr, zero, _CMP_GT_OQ);
+        miss = _mm256_or_pd(miss, _mm256_cmp_pd(dvdv, zero, _CMP_EQ_OQ));
+        miss = _mm256_or_pd(miss, _mm256_cmp_pd(drdr, sigma2, _CMP_LT_OQ));
+        miss = _mm256_or_pd(miss, _mm256_cmp_pd(d, zero, _CMP_LT_OQ));
+        miss = _mm256_or_pd(miss, _mm256_cmp_pd(hit, zero, _CMP_LT_OQ));
+
+        _mm256_storeu_pd(&out[j], _mm256_blendv_pd(hit, infinity, miss));
+    }
+#endif
+
+    for (; j < n; ++j) {
+        Particle that;
+        that.v = {vx[j], vy[j]};
+        that.r = {rx[j], ry[j]};
+        that.move(time - t[j]);
+        that.radius = radius[j];
+        out[j] = particle.timeToHit(that);
+    }
+}
+
+}  // namespace particlesystem
@@ -0,0 +1,93 @@
+#include <particlesystem/randomparticles.h>
+
+#include <random>
+#include <numbers>
+#include <cmath>
+#include <algorithm>
+
+namespace particlesystem {
+
+namespace {
+
+/**
+ * Place n particles of the given radius uniformly at random in the unit box, without overlaps,
+ * by random sequential addition: a candidate position is rejected if it overlaps a particle
+ * already placed. The placed particles are kept in a grid of cells of side at least 2 * radius,
+ * so that a candidate is only tested against the particles of 9 cells
+ * Return an empty vector if too many candidates in a row are rejected
+ */
+std::vector<glm::dvec2> placeParticles(long long n, double radius, std::mt19937_64& gen) {
+    const int m = std::max(1, static_cast<int>(1.0 / (2.0 * radius)));  // cells per side
+    std::vector<int> head(static_cast<std::size_t>(m) * m, -1);  // first particle of each cell
+    std::vector<int> next;  // next particle in the same cell, -1 for none
+    std::vector<glm::dvec2> positions;
+    positions.reserve(n);
+    next.reserve(n);
+
+    std::uniform_real_distribution<double> coordinate{radius, 1.0 - radius};
+    const auto cellOf = [&](double x) { return std::min(static_cast<int>(x * m), m - 1); };
+
+    constexpr int max_rejections = 100000;
+    int rejections = 0;
+    while (std::ssize(positions) < n) {
+        const glm::dvec2 r{coordinate(gen), coordinate(gen)};
+        const int cx = cellOf(r.x);
+        const int cy = cellOf(r.y);
+
+        bool overlaps = false;
+        for (int y = std::max(cy - 1, 0); y <= std::min(cy + 1, m - 1) && !overlaps; ++y) {
+            for (int x = std::max(cx - 1, 0); x <= std::min(cx + 1, m - 1) && !overlaps; ++x) {
+                for (int j = head[y * m + x]; j != -1 && !overlaps; j = next[j]) {
+                    const glm::dvec2 d = positions[j] - r;
+                    overlaps = glm::dot(d, d) < 4.0 * radius * radius;
+                }
+            }
+        }
+
+        if (overlaps) {
+            if (++rejections == max_rejections) return {};
+            continue;
+        }
+
+        rejections = 0;
+        next.push_back(head[cy * m + cx]);
+        head[cy * m + cx] = static_cast<int>(positions.size());
+        positions.push_back(r);
+    }
+    return positions;
+}
+
+}  // namespace
+
+/**
+ * Random configuration of n particles of equal radius and mass, placed uniformly in the unit
+ * box without overlaps
+ * Return an empty vector if the particles cannot be placed
+ */
+std::vector<Particle> random_particles(long long n, double fraction, double speed, double mass,
+                                       std::uint32_t seed) {
+    if (n <= 0 || fraction <= 0.0 || fraction >= 0.5) {
+        return {};
+    }
+
+    // n disks of radius r cover the fraction n * pi * r^2 of the box
+    const double radius = std::sqrt(fraction / (n * std::numbers::pi));
+
+    std::mt19937_64 gen{seed};
+    const auto positions = placeParticles(n, radius, gen);
+
+    std::normal_distribution<double> velocity{0.0, speed};
+    std::uniform_int_distribution<int> channel{40, 255};
+
+    std::vector<Particle> particles;
+    particles.reserve(positions.size());
+    for (const auto& r : positions) {
+        const glm::dvec2 v{velocity(gen), velocity(gen)};
+        const Color color{channel(gen) / 255.0f, channel(gen) / 255.0f, channel(gen) / 255.0f};
+        particles.push_back(
+            Particle{.r = r, .v = v, .radius = radius, .mass = mass, .color = color});
+    }
+    return particles;
+}
+
+}  // namespace particlesystem
@@ -0,0 +1,143 @@
+#include <particlesystem/readfiles.h>
+
+#include <fstream>
+#include <cmath>
+#include <charconv>
+#include <cstdlib>
+#include <type_traits>
+#include <cctype>
+#include <string>
+#include <string_view>
+#include <algorithm>
+#include <system_error>
+
+namespace particlesystem {
+
+namespace {
+
+// std::from_chars of floating-point types is missing from some standard libraries, e.g. the
+// libc++ of Xcode, which then do not define __cpp_lib_to_chars
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+constexpr bool from_chars_floating_point = true;
+#else
+constexpr bool from_chars_floating_point = false;
+#endif
+
+/**
+ * Help class to read the numbers of a text one after another with std::from_chars,
+ * which does not depend on the locale and does not copy the text
+ * Without std::from_chars of floating-point types, those are read with std::strtod, in the
+ * "C" locale of the program, so the text must be followed by a '\0'
+ */
+class NumberReader {
+public:
+    explicit NumberReader(std::string_view text)
+        : next{text.data()}, end{text.data() + text.size()} {}
+
+    /**
+     * Read the next number, after any whitespace, into value
+     * Return false if there is no number of type T
+     */
+    template <class T>
+    bool read(T& value) {
+        while (next != end && std::isspace(static_cast<unsigned char>(*next))) {
+            ++next;
+        }
+        if (next != end && *next == '+') {  // not accepted by std::from_chars
+            ++next;
+        }
+
+        if constexpr (std::is_floating_point_v<T> && !from_chars_floating_point) {
+            char* last = nullptr;
+            const double x = std::strtod(next, &last);
+            if (last == next || last > end) {
+                return false;
+            }
+            value = static_cast<T>(x);
+            next = last;
+            return true;
+        } else {
+            const auto [last, error] = std::from_chars(next, end, value);
+            next = last;
+            return error == std::errc{};
+        }
+    }
+
+private:
+    const char* next;
+    const char* end;
+};
+
+}  // namespace
+
+/**
+ * Read particles for the simulation from file
+ * Return an empty vector if the file cannot be opened or is not a particles file
+ * The file is read in one block and parsed in place, so that files with millions of
+ * particles are read at the speed of the disk
+ */
+std::vector<Particle> read_particles(const std::filesystem::path& file) {
+    std::ifstream is(file, std::ios::binary | std::ios::ate);
+    if (!is) {
+        return {};
+    }
+
+    std::string text(static_cast<std::size_t>(is.tellg()), '\0');
+    is.seekg(0);
+    if (!is.read(text.data(), static_cast<std::streamsize>(text.size()))) {
+        return {};
+    }
+
+    NumberReader reader{text};
+
+    long long n_particles;
+    if (!reader.read(n_particles) || n_particles < 0) {  // read number of particles
+        return {};
+    }
+
+    std::vector<Particle> particles;
+    particles.reserve(static_cast<std::size_t>(
+        std::min<long long>(n_particles, static_cast<long long>(text.size()))));
+
+    double rx, ry;
+    double vx, vy;
+    double radius;
+    double mass;
+    float r, g, b;
+    for (long long i = 0; i < n_particles; ++i) {
+        if (!(reader.read(rx) && reader.read(ry) && reader.read(vx) && reader.read(vy) &&
+              reader.read(radius) && reader.read(mass) && reader.read(r) && reader.read(g) &&
+              reader.read(b))) {
+            return {};
+        }
+        particles.push_back(Particle{.r = {rx, ry},
+                                     .v = {vx, vy},
+                                     .radius = radius,
+                                     .mass = mass,
+                                     .color = {r / 255.0f, g / 255.0f, b / 255.0f}});
+    }
+    return particles;
+}
+
+/**
+ * Write particles to file, in the format read by read_particles
+ * Return false if the file cannot be written
+ */
+bool write_particles(const std::filesystem::path& file, std::span<const Particle> particles) {
+    std::ofstream os(file);
+    if (!os) {
+        return false;
+    }
+
+    os << particles.size() << '\n';
+    os.precision(17);  // positions and velocities are read back exactly
+    for (const auto& p : particles) {
+        os << p.r.x << ' ' << p.r.y << ' ' << p.v.x << ' ' << p.v.y << ' ';
+        os << p.radius << ' ' << p.mass << ' ';
+        os << std::lround(p.color.r * 255.0f) << ' ' << std::lround(p.color.g * 255.0f) << ' '
+           << std::lround(p.color.b * 255.0f) << '\n';
+    }
+    return static_cast<bool>(os);
+}
+
+}  // namespace particlesystem
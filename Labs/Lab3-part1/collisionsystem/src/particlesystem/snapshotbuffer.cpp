@@ -0,0 +1,33 @@
+#include <particlesystem/snapshotbuffer.h>
+
+#include <utility>
+
+namespace particlesystem {
+
+/**
+ * Copy particles to a new snapshot and make it the latest one
+ * The copy is made outside the lock, into the buffer that only the simulation uses
+ */
+void SnapshotBuffer::publish(std::span<const Particle> particles) {
+    buffers[backIndex].assign(particles.begin(), particles.end());
+
+    std::lock_guard lock{mutex};
+    std::swap(backIndex, readyIndex);
+    fresh = true;
+}
+
+/**
+ * Make the latest published snapshot the front snapshot
+ * Return false if no snapshot was published since the last call
+ */
+bool SnapshotBuffer::acquire() {
+    std::lock_guard lock{mutex};
+    if (!fresh) {
+        return false;
+    }
+    std::swap(frontIndex, readyIndex);
+    fresh = false;
+    return true;
+}
+
+}  // namespace particlesystem
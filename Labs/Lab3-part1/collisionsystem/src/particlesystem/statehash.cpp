@@ -0,0 +1,49 @@
+#include <particlesystem/statehash.h>
+
+#include <bit>
+
+namespace particlesystem {
+
+namespace {
+
+/**
+ * Help function to mix the bits of x (the finaliser of splitmix64)
+ */
+std::uint64_t mix(std::uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111eb;
+    x ^= x >> 31;
+    return x;
+}
+
+/**
+ * Help function to add the bits of value to hash
+ */
+template <class T>
+void combine(std::uint64_t& hash, T value) {
+    const auto bits = std::bit_cast<std::uint64_t>(value);
+    hash = mix(hash ^ (bits + 0x9e3779b97f4a7c15));
+}
+
+}  // namespace
+
+/**
+ * Hash of the state of particles at time: the bits of their positions at time, their
+ * velocities and their collision counters, in the order of the particles
+ */
+std::uint64_t hash_particles(std::span<const Particle> particles, double time) {
+    std::uint64_t hash = particles.size();
+    for (Particle p : particles) {
+        p.moveTo(time);
+        combine(hash, p.r.x);
+        combine(hash, p.r.y);
+        combine(hash, p.v.x);
+        combine(hash, p.v.y);
+        combine(hash, static_cast<std::int64_t>(p.count));
+    }
+    return hash;
+}
+
+}  // namespace particlesystem
@@ -0,0 +1,85 @@
+#include <particlesystem/threadpool.h>
+
+#include <algorithm>
+
+namespace particlesystem {
+
+/**
+ * Constructor to create a pool with the given number of threads, including the calling thread
+ */
+ThreadPool::ThreadPool(int threads) {
+    for (int t = 1; t < std::max(threads, 1); ++t) {
+        workers.emplace_back(&ThreadPool::work, this, t);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard lock{mutex};
+        stop = true;
+    }
+    wake.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+/**
+ * Call f(t, first, last) on thread t for the t:th range [first, last) of [0, n)
+ * and wait until all calls have returned
+ */
+void ThreadPool::parallelFor(int n, const std::function<void(int, int, int)>& f) {
+    if (workers.empty() || n < 2) {
+        if (n > 0) f(0, 0, n);
+        return;
+    }
+
+    {
+        std::lock_guard lock{mutex};
+        task = &f;
+        count = n;
+        running = static_cast<int>(workers.size());
+        ++generation;
+    }
+    wake.notify_all();
+
+    const auto [first, last] = range(0, n);
+    if (first < last) f(0, first, last);
+
+    std::unique_lock lock{mutex};
+    finished.wait(lock, [this] { return running == 0; });
+    task = nullptr;
+}
+
+/**
+ * Range of thread t in [0, n)
+ */
+std::pair<int, int> ThreadPool::range(int t, int n) const {
+    const long long threads = size();
+    return {static_cast<int>(t * 1LL * n / threads), static_cast<int>((t + 1LL) * n / threads)};
+}
+
+/**
+ * Loop of worker thread t: wait for a loop to start and run range t of it
+ */
+void ThreadPool::work(int t) {
+    std::uint64_t seen = 0;  // last loop run by this thread
+
+    while (true) {
+        std::unique_lock lock{mutex};
+        wake.wait(lock, [&] { return stop || generation != seen; });
+        if (stop) return;
+
+        seen = generation;
+        const auto& f = *task;
+        const auto [first, last] = range(t, count);
+        lock.unlock();
+
+        if (first < last) f(t, first, last);
+
+        lock.lock();
+        if (--running == 0) finished.notify_one();
+    }
+}
+
+}  // namespace particlesystem
@@ -0,0 +1,351 @@
+#include <vector>
+#include <string>
+#include <string_view>
+#include <filesystem>
+#include <fstream>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <atomic>
+#include <new>
+#include <algorithm>
+
+#include <particlesystem/collisionsystem.h>
+#include <particlesystem/readfiles.h>
+#include <particlesystem/randomparticles.h>
+
+#include <fmt/format.h>
+
+using namespace particlesystem;
+
+const std::filesystem::path data_dir{DATA_DIR};
+
+namespace {
+
+using Scheduling = CollisionSystem::Scheduling;
+using BroadPhase = CollisionSystem::BroadPhase;
+
+/**
+ * Options of the suite, given on the command line
+ */
+struct Options {
+    std::filesystem::path json;          // JSON output file, empty for none
+    long long maxParticles = 1'000'000;  // largest generated system
+    int threads = 0;                     // prediction threads, 0 for the default
+};
+
+void printUsage() {
+    fmt::print(stderr,
+               "Usage: lab3-throughput [options]\n"
+               "  --json <file>            write the results as JSON to file\n"
+               "  --max-particles <n>      largest generated system (default 1000000)\n"
+               "  --threads <n>            number of threads for predictions\n");
+}
+
+/**
+ * Parse the command line
+ * Return false if it is not valid
+ */
+bool parseOptions(int argc, char* argv[], Options& options) {
+    try {
+        for (int i = 1; i < argc; ++i) {
+            const std::string_view option = argv[i];
+            if (i + 1 == argc) {  // all options take a value
+                return false;
+            }
+
+            if (option == "--json") {
+                options.json = argv[++i];
+            } else if (option == "--max-particles") {
+                options.maxParticles = std::stoll(argv[++i]);
+            } else if (option == "--threads") {
+                options.threads = std::stoi(argv[++i]);
+            } else {
+                return false;
+            }
+        }
+    } catch (const std::exception&) {  // std::stoll or std::stoi failed
+        return false;
+    }
+    return options.maxParticles > 0 && options.threads >= 0;
+}
+
+std::atomic<std::size_t> liveBytes{0};  // bytes allocated by operator new and not freed
+std::atomic<std::size_t> peakBytes{0};  // largest liveBytes since the last resetPeakBytes
+
+/**
+ * Start a new measurement of the peak of liveBytes, from the bytes allocated now
+ */
+std::size_t resetPeakBytes() {
+    const std::size_t live = liveBytes.load();
+    peakBytes.store(live);
+    return live;
+}
+
+/**
+ * Allocate size bytes aligned to alignment, and count them in liveBytes and peakBytes
+ * The size and the block returned by malloc are stored just before the returned address
+ */
+void* allocate(std::size_t size, std::size_t alignment) {
+    constexpr std::size_t header = 2 * sizeof(void*);
+    void* block = std::malloc(size + header + alignment);
+    if (block == nullptr) {
+        throw std::bad_alloc{};
+    }
+
+    const std::uintptr_t first = reinterpret_cast<std::uintptr_t>(block) + header;
+    void** p = reinterpret_cast<void**>((first + alignment - 1) / alignment * alignment);
+    p[-1] = block;
+    p[-2] = reinterpret_cast<void*>(size);
+
+    const std::size_t live = liveBytes.fetch_add(size) + size;
+    std::size_t peak = peakBytes.load();
+    while (live > peak && !peakBytes.compare_exchange_weak(peak, live)) {
+    }
+    return p;
+}
+
+/**
+ * Free a block of allocate
+ */
+void deallocate(void* ptr) noexcept {
+    if (ptr == nullptr) return;
+    void** p = static_cast<void**>(ptr);
+    liveBytes.fetch_sub(reinterpret_cast<std::size_t>(p[-2]));
+    std::free(p[-1]);
+}
+
+/**
+ * A system to simulate: a file in /data or a generated system
+ */
+struct Scenario {
+    std::string name;
+    std::vector<Particle> particles;
+    double simulationTime;
+};
+
+/**
+ * The results of one simulation of a scenario
+ */
+struct Run {
+    std::string scenario;
+    std::size_t particles;
+    Scheduling scheduling;
+    BroadPhase broadPhase;
+    CollisionSystem::Statistics untimed;  // run without timers, for the throughput
+    CollisionSystem::Statistics timed;    // run with timers, for the cost of each phase
+    std::size_t memoryBytes;              // peak heap memory of the untimed run
+
+    double eventsPerSecond() const {
+        return untimed.wallSeconds > 0.0 ? untimed.events / untimed.wallSeconds : 0.0;
+    }
+    double nsPerPredict() const {
+        return timed.predictions > 0 ? 1e9 * timed.predictSeconds / timed.predictions : 0.0;
+    }
+    std::int64_t queueOperations() const { return timed.queueInserts + timed.queueRemovals; }
+    double nsPerQueueOperation() const {
+        return queueOperations() > 0 ? 1e9 * timed.queueSeconds / queueOperations() : 0.0;
+    }
+};
+
+std::string_view name(Scheduling scheduling) {
+    if (scheduling == Scheduling::Lazy) return "lazy";
+    if (scheduling == Scheduling::Indexed) return "indexed";
+    return "regions";
+}
+
+std::string_view name(BroadPhase broadPhase) {
+    return broadPhase == BroadPhase::AllPairs ? "all-pairs" : "grid";
+}
+
+std::string_view eventQueueName() {
+#if defined(USE_PRIORITY_QUEUE_VECTOR)
+    return "sorted vector";
+#elif defined(USE_PAIRING_HEAP)
+    return "pairing heap";
+#elif defined(USE_RADIX_HEAP)
+    return "radix heap";
+#elif defined(USE_CALENDAR_QUEUE)
+    return "calendar queue";
+#else
+    return "heap";
+#endif
+}
+
+/**
+ * Simulate scenario once without and once with the timers of CollisionSystem
+ * The timers cost two clock readings per prediction and queue operation, so the throughput
+ * is measured without them
+ */
+Run simulate(const Scenario& scenario, Scheduling scheduling, BroadPhase broadPhase,
+             int threads) {
+    Run run{.scenario = scenario.name,
+            .particles = scenario.particles.size(),
+            .scheduling = scheduling,
+            .broadPhase = broadPhase,
+            .untimed = {},
+            .timed = {},
+            .memoryBytes = 0};
+
+    for (bool timing : {false, true}) {
+        const std::size_t before = resetPeakBytes();
+        CollisionSystem system{scenario.particles};
+        system.scheduling = scheduling;
+        system.broadPhase = broadPhase;
+        system.timing = timing;
+        if (threads > 0) {
+            system.threads = threads;
+        }
+
+        system.simulate(scenario.simulationTime, 0.0);
+        (timing ? run.timed : run.untimed) = system.statistics();
+        if (!timing) {
+            run.memoryBytes = peakBytes.load() - before;
+        }
+    }
+    return run;
+}
+
+void printHeader() {
+    fmt::print("{:<16} {:>9} {:>8} {:>10} {:>10} {:>10} {:>12} {:>10} {:>10} {:>10}\n",
+               "scenario", "particles", "schedule", "broad", "events", "wall (s)", "events/s",
+               "ns/predict", "ns/queue", "memory MB");
+}
+
+void printRun(const Run& run) {
+    fmt::print(
+        "{:<16} {:>9} {:>8} {:>10} {:>10} {:>10.3f} {:>12.0f} {:>10.1f} {:>10.1f} {:>10.1f}\n",
+        run.scenario, run.particles, name(run.scheduling), name(run.broadPhase),
+        run.untimed.events, run.untimed.wallSeconds, run.eventsPerSecond(), run.nsPerPredict(),
+        run.nsPerQueueOperation(), run.memoryBytes / 1e6);
+}
+
+/**
+ * Write the results as a JSON document, one object per run
+ */
+bool writeJson(const std::filesystem::path& file, const std::vector<Run>& runs, int threads) {
+    std::ofstream os(file);
+    os << fmt::format("{{\n  \"eventQueue\": \"{}\",\n  \"heapArity\": {},\n  \"threads\": {},\n",
+                      eventQueueName(), PRIORITY_QUEUE_ARITY, threads);
+    os << fmt::format("  \"eventBytes\": {},\n  \"particleBytes\": {},\n  \"runs\": [\n",
+                      sizeof(Event), sizeof(Particle));
+
+    for (std::size_t i = 0; i < runs.size(); ++i) {
+        const Run& run = runs[i];
+        os << fmt::format(
+            "    {{\"scenario\": \"{}\", \"particles\": {}, \"scheduling\": \"{}\", "
+            "\"broadPhase\": \"{}\", \"simulatedTime\": {:.17g}, \"events\": {}, "
+            "\"invalidated\": {}, \"wallSeconds\": {:.6f}, \"eventsPerSecond\": {:.1f}, "
+            "\"predictions\": {}, \"nsPerPredict\": {:.2f}, \"queueOperations\": {}, "
+            "\"nsPerQueueOperation\": {:.2f}, \"moveSeconds\": {:.6f}, \"peakQueueSize\": {}, "
+            "\"memoryBytes\": {}}}{}\n",
+            run.scenario, run.particles, name(run.scheduling), name(run.broadPhase),
+            run.untimed.simulatedTime - run.untimed.startTime, run.untimed.events,
+            run.untimed.invalidated, run.untimed.wallSeconds, run.eventsPerSecond(),
+            run.timed.predictions, run.nsPerPredict(), run.queueOperations(),
+            run.nsPerQueueOperation(), run.timed.moveSeconds, run.untimed.peakQueueSize,
+            run.memoryBytes, i + 1 < runs.size() ? "," : "");
+    }
+    os << "  ]\n}\n";
+    return static_cast<bool>(os);
+}
+
+}  // namespace
+
+/*
+ * Count the heap memory allocated on every thread, for the memory of the runs
+ * The array and nothrow forms of operator new and delete call these
+ */
+void* operator new(std::size_t size) { return allocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__); }
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    return allocate(size, std::max(static_cast<std::size_t>(alignment),
+                                   std::size_t{__STDCPP_DEFAULT_NEW_ALIGNMENT__}));
+}
+
+void operator delete(void* p) noexcept { deallocate(p); }
+
+void operator delete(void* p, std::size_t) noexcept { deallocate(p); }
+
+void operator delete(void* p, std::align_val_t) noexcept { deallocate(p); }
+
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { deallocate(p); }
+
+/*
+ * Measure the throughput of CollisionSystem::simulate, without rendering, on the scenarios in
+ * /data and on generated systems of 1K to 1M particles, for each scheduling and broad phase
+ * To compare the event queues, configure with -DPRIORITY_QUEUE_ARITY=2 (4, 8)
+ * or -DEVENT_QUEUE=PRIORITY_QUEUE_VECTOR (PAIRING_HEAP, RADIX_HEAP, CALENDAR_QUEUE)
+ */
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage();
+        return 1;
+    }
+
+    struct Size {
+        std::string file;  // file in /data, empty for a generated system
+        long long n;       // number of particles of a generated system
+        double simulationTime;
+    };
+
+    // the collisions per particle and time unit of a generated system grow as the square root
+    // of the number of particles, the simulation times give a few collisions per particle
+    const std::vector<Size> sizes{{"billiards10.txt", 0, 10000.0}, {"diffusion.txt", 0, 3000.0},
+                                  {"brownian.txt", 0, 300.0},      {"", 1'000, 5.0},
+                                  {"", 10'000, 2.0},               {"", 100'000, 0.5},
+                                  {"", 1'000'000, 0.15}};
+
+    std::vector<Scenario> scenarios;
+    for (const auto& [file, n, simulationTime] : sizes) {
+        if (!file.empty()) {
+            scenarios.push_back({file, read_particles(data_dir / file), simulationTime});
+        } else if (n <= options.maxParticles) {
+            scenarios.push_back({fmt::format("random-{}", n),
+                                 random_particles(n, 0.2, 0.01, 0.01, 1), simulationTime});
+        } else {
+            continue;
+        }
+
+        if (scenarios.back().particles.empty()) {
+            fmt::print(stderr, "Could not create {}\n", scenarios.back().name);
+            return 1;
+        }
+    }
+
+    // all-pairs prediction tests every particle, O(n) per event
+    constexpr std::size_t max_linear = 10'000;
+
+    const int threads = options.threads > 0 ? options.threads
+                                            : CollisionSystem{std::vector<Particle>{}}.threads;
+    fmt::print("event queue: {} (heap D={}), prediction threads: {}\n", eventQueueName(),
+               PRIORITY_QUEUE_ARITY, threads);
+    printHeader();
+
+    std::vector<Run> runs;
+    for (const auto& scenario : scenarios) {
+        for (BroadPhase broadPhase : {BroadPhase::AllPairs, BroadPhase::Grid}) {
+            for (Scheduling scheduling :
+                 {Scheduling::Lazy, Scheduling::Indexed, Scheduling::Regions}) {
+                const bool linear = broadPhase == BroadPhase::AllPairs;
+                if (linear && scenario.particles.size() > max_linear) continue;
+                // without the grid, region scheduling is lazy scheduling
+                if (scheduling == Scheduling::Regions && broadPhase != BroadPhase::Grid) continue;
+
+                runs.push_back(simulate(scenario, scheduling, broadPhase, threads));
+                printRun(runs.back());
+                std::fflush(stdout);
+            }
+        }
+    }
+
+    if (!options.json.empty()) {
+        if (!writeJson(options.json, runs, threads)) {
+            fmt::print(stderr, "Could not write {}\n", options.json.string());
+            return 1;
+        }
+        fmt::print("results written to {}\n", options.json.string());
+    }
+}
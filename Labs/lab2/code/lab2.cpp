@@ -311,5 +311,76 @@ int main() {
     }
     assert(Set::get_count_nodes() == 0);
 
+    /*****************************************************
+     * TEST PHASE 10                                      *
+     * Comparisons decided by cardinality and early exit  *
+     ******************************************************/
+    std::cout << "\nTEST PHASE 10: early exit in == and <=>\n";
+
+    {
+        Set S1{std::vector<int>{1, 2, 3}};
+        Set S2{std::vector<int>{1, 2, 4}};
+        Set S3{std::vector<int>{0, 1, 2, 3, 9}};
+        Set S4{std::vector<int>{0, 2, 3, 9}};
+
+        // Test: same cardinality, so either equivalent or unordered
+        assert(S1 != S2);
+        assert((S1 <=> S2) == std::partial_ordering::unordered);
+        assert((S1 <=> Set{std::vector<int>{1, 2, 3}}) == std::partial_ordering::equivalent);
+
+        // Test: smaller cardinality, so either less or unordered
+        assert(S1 < S3);
+        assert((S2 <=> S3) == std::partial_ordering::unordered);
+        assert((S1 <=> S4) == std::partial_ordering::unordered);
+        assert(Set{} < S1);
+
+        // Test: larger cardinality, so either greater or unordered
+        assert(S3 > S4);
+        assert((S3 <=> S2) == std::partial_ordering::unordered);
+
+        // Test: hash follows the values, not the order of the updates
+        Set S5{std::vector<int>{1, 2}};
+        S5 += 3;
+        assert(S5 == S1);
+        S5 -= 3;
+        S5 += 4;
+        assert(S5 == S2);
+        S5 *= S1;
+        assert(S5 == Set(std::vector<int>{1, 2}));
+    }
+
+    assert(Set::get_count_nodes() == 0);
+
+    /*****************************************************
+     * TEST PHASE 11                                      *
+     * Batched updates: insert_many and erase_many        *
+     ******************************************************/
+    std::cout << "\nTEST PHASE 11: insert_many and erase_many\n";
+
+    {
+        Set S1{std::vector<int>{2, 4, 6}};
+
+        S1.insert_many({9, 1, 4, 5, 1, 10});
+        assert(Set::get_count_nodes() == 9);
+
+        // Test
+        assert(S1 == Set(std::vector<int>{1, 2, 4, 5, 6, 9, 10}));
+
+        S1.erase_many({10, 3, 1, 6, 6, 99});
+        assert(Set::get_count_nodes() == 6);
+
+        // Test
+        assert(S1 == Set(std::vector<int>{2, 4, 5, 9}));
+
+        S1.erase_many({});
+        S1.insert_many({});
+        assert(S1.cardinality() == 4);
+
+        S1.erase_many({9, 5, 4, 2});
+        assert(S1.is_empty());
+    }
+
+    assert(Set::get_count_nodes() == 0);
+
     std::cout << "Success!!\n";
 }
@@ -1,6 +1,9 @@
 #include "set.h"
 #include "node.h"
 
+#include <cstdint>
+#include <algorithm>
+
 int Set::Node::count_nodes = 0;
 
 /*****************************************************
@@ -17,7 +20,7 @@ int Set::get_count_nodes() {
 /*
  *  Default constructor :create an empty Set
  */
-Set::Set() : counter{0} {
+Set::Set() : counter{0}, hash{0} {
     // IMPLEMENT before Lab2 HA
     head = new Node{};
     tail = new Node{};
@@ -97,6 +100,7 @@ Set& Set::operator=(Set S) {
     std::swap(head, S.head);
     std::swap(tail, S.tail);
     std::swap(counter, S.counter);
+    std::swap(hash, S.hash);
     return *this;
 }
 
@@ -124,42 +128,45 @@ bool Set::is_member(int val) const {
  * Requirement: must iterate through each set no more than once
  */
 std::partial_ordering Set::operator<=>(const Set& S) const {
+    // Equal cardinalities: only equivalent or unordered are possible
+    // Smaller cardinality: only less or unordered are possible
+    // Larger cardinality: only greater or unordered are possible
+    if (counter == S.counter) {
+        return (*this == S) ? std::partial_ordering::equivalent : std::partial_ordering::unordered;
+    }
+
     Node* a = head->next;
     Node* b = S.head->next;
 
-    bool a_missing = false;
-    bool b_missing = false;
-
-    while (a != tail && b != S.tail) {
-        if (a->value == b->value) {
+    if (counter < S.counter) {
+        // *this < S iff every value of *this is found in S
+        while (a != tail) {
+            while (b != S.tail && b->value < a->value) {
+                b = b->next;
+            }
+            if (b == S.tail || b->value != a->value) {
+                return std::partial_ordering::unordered;  // *this has a value S doesn't
+            }
             a = a->next;
             b = b->next;
         }
-        else if (a->value < b->value) {
-            b_missing = true;  // *this has a value S doesn't
+        return std::partial_ordering::less;
+    }
+
+    // *this > S iff every value of S is found in *this
+    while (b != S.tail) {
+        while (a != tail && a->value < b->value) {
             a = a->next;
         }
-        else { // a->value > b->value
-            a_missing = true;  // S has a value *this doesn't
-            b = b->next;
+        if (a == tail || a->value != b->value) {
+            return std::partial_ordering::unordered;  // S has a value *this doesn't
         }
-    }
-    while (a != tail) {
-        b_missing = true;  // *this has extra elements
         a = a->next;
-    }
-
-    while (b != S.tail) {
-        a_missing = true;  // S has extra elements
         b = b->next;
     }
-    if (!a_missing && !b_missing) return std::partial_ordering::equivalent;
-    if (!a_missing && b_missing)  return std::partial_ordering::greater;
-    if (a_missing && !b_missing)  return std::partial_ordering::less;
-    return std::partial_ordering::unordered;
+    return std::partial_ordering::greater;
 }
 
-
 /*
  * Test whether Set *this and S represent the same set
  * Return true, if *this has same elemnts as set S
@@ -169,17 +176,21 @@ std::partial_ordering Set::operator<=>(const Set& S) const {
  */
 bool Set::operator==(const Set& S) const {
     // IMPLEMENT before Lab2 HA
+    if (counter != S.counter || hash != S.hash) {
+        return false;
+    }
+
     Node* a = head->next;
     Node* b = S.head->next;
 
-    while (a != tail && b != S.tail) {
+    while (a != tail) {  // same cardinality, so both lists end together
         if (a->value != b->value)
             return false;
         a = a->next;
         b = b->next;
     }
 
-    return (a == tail && b == S.tail);
+    return true;
 }
 
 /*
@@ -272,6 +283,50 @@ Set& Set::operator-=(const Set& S) {
     return *this;
 }
 
+/*
+ * Insert all values in batch into the Set *this
+ * \param batch values to be inserted, in any order and possibly with repetitions
+ */
+void Set::insert_many(std::vector<int> batch) {
+    std::sort(batch.begin(), batch.end());
+
+    Node* current = head;
+    for (auto it = batch.begin(); it != batch.end(); ++it) {
+        if (it != batch.begin() && *it == *(it - 1)) {
+            continue;  // repeated value in the batch
+        }
+        while (current->next != tail && current->next->value < *it) {
+            current = current->next;
+        }
+        if (current->next == tail || current->next->value != *it) {
+            insert_node(current, *it);
+        }
+        current = current->next;
+    }
+}
+
+/*
+ * Remove all values in batch from the Set *this
+ * \param batch values to be removed, in any order and possibly with repetitions
+ */
+void Set::erase_many(std::vector<int> batch) {
+    std::sort(batch.begin(), batch.end());
+
+    Node* current = head->next;
+    for (int val : batch) {
+        while (current != tail && current->value < val) {
+            current = current->next;
+        }
+        if (current == tail) {
+            break;
+        }
+        if (current->value == val) {
+            Node* deleteNode = current;
+            current = current->next;
+            remove_node(deleteNode);
+        }
+    }
+}
 
 /* ******************************************** *
  * Private Member Functions -- Implementation   *
@@ -289,6 +344,7 @@ void Set::insert_node(Node* p, int val) {
     p->next = newNode;
     // p <-> newNode <-> oldNext
     ++counter;
+    hash += hash_value(val);
 }
 
 /*
@@ -297,12 +353,26 @@ void Set::insert_node(Node* p, int val) {
  */
 void Set::remove_node(Node* p) {
     // IMPLEMENT before Lab2 HA
+    hash -= hash_value(p->value);
     p->prev->next = p->next;
     p->next->prev = p->prev;
     delete p;
     --counter;
 }
 
+/*
+ * Hash of a single value, combined by addition into the hash of the Set
+ * Addition makes the Set hash independent of insertion order and cheap to undo
+ * \param val value to be hashed
+ */
+size_t Set::hash_value(int val) {
+    // splitmix64 finalizer: spreads consecutive ints over all bits
+    uint64_t x = static_cast<uint64_t>(static_cast<uint32_t>(val)) + 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return static_cast<size_t>(x ^ (x >> 31));
+}
+
 /*
  * Write Set *this to stream os
  */
@@ -90,6 +90,8 @@ public:
      * Return std::partial_ordering::unordered, otherwise (Sets *this and S are not comparable)
      * 
      * Requirement: S1<=>S2 should iterate through each set S1 and S2 no more than once
+     * The cardinalities rule out impossible outcomes up front and
+     * the iteration stops as soon as the result is decided
      */
     std::partial_ordering operator<=>(const Set& S) const;
 
@@ -99,6 +101,7 @@ public:
      * Return false, otherwise
      * 
      * Requirement: S1 == S2 should iterate through each set S1 and S2 no more than once
+     * Sets with different cardinality or hash are rejected in constant time
      */
     bool operator==(const Set& S) const;
 
@@ -120,6 +123,21 @@ public:
      */
     Set& operator-=(const Set& S);
 
+    /*
+     * Insert all values in batch into the Set *this
+     * \param batch values to be inserted, in any order and possibly with repetitions
+     * The batch is sorted and then merged into the list in a single pass
+     */
+    void insert_many(std::vector<int> batch);
+
+    /*
+     * Remove all values in batch from the Set *this
+     * \param batch values to be removed, in any order and possibly with repetitions
+     * Values not in the Set are ignored
+     * The batch is sorted and then merged with the list in a single pass
+     */
+    void erase_many(std::vector<int> batch);
+
     /*
      * Return number of existing nodes
      * Used solely for debug purposes
@@ -172,6 +190,7 @@ private:
     Node* head;      // pointer to the dummy header Node
     Node* tail;      // pointer to the dummy tail Node
     size_t counter;  // number of values in the Set
+    size_t hash;     // order-independent hash of the values, updated by insert_node/remove_node
 
     /* ************************** *
      * Private Member Functions    *
@@ -190,6 +209,12 @@ private:
      */
     void remove_node(Node* p);
 
+    /*
+     * Hash of a single value, combined by addition into the hash of the Set
+     * \param val value to be hashed
+     */
+    static size_t hash_value(int val);
+
     /*
      * Write Set *this to stream os
      */
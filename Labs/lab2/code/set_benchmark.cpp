@@ -0,0 +1,160 @@
+/*
+ * Benchmark of the Set operations
+ *
+ * Measures construction, is_member, union, intersection, difference and <=>
+ * for sets of 1K up to max_size values (default 1M, first command line argument)
+ * and for several overlap ratios between the two operand sets
+ * <=> compares a set with a strict superset, so that the subset test visits every value
+ *
+ * Reported per operation:
+ *  - ns/elem: time divided by the number of values in both operands
+ *  - allocs: number of calls to operator new
+ *  - RSS: resident memory of the process after the two operands are built
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+#include "set.h"
+
+namespace {
+
+size_t allocations = 0;  // number of calls to operator new so far
+volatile bool sink;      // keeps the results of the const operations observable
+
+/*
+ * Resident memory of the process in MiB, 0 if unknown on this platform
+ */
+double resident_MiB() {
+    std::ifstream statm{"/proc/self/statm"};
+    size_t pages = 0;
+    size_t resident = 0;
+    if (!(statm >> pages >> resident)) {
+        return 0.0;
+    }
+    return resident * 4096.0 / (1024.0 * 1024.0);  // assumes 4 KiB pages
+}
+
+struct Measure {
+    double ns = 0.0;      // time per repetition
+    double allocs = 0.0;  // allocations per repetition
+};
+
+/*
+ * Run op reps times, setup is run before each repetition and is not measured
+ */
+template <typename Setup, typename Op>
+Measure measure(int reps, Setup setup, Op op) {
+    Measure m;
+    for (int i = 0; i < reps; ++i) {
+        auto state = setup();
+        const size_t allocs_before = allocations;
+        const auto start = std::chrono::steady_clock::now();
+        op(state);
+        const auto stop = std::chrono::steady_clock::now();
+        m.allocs += allocations - allocs_before;
+        m.ns += std::chrono::duration<double, std::nano>(stop - start).count();
+    }
+    m.ns /= reps;
+    m.allocs /= reps;
+    return m;
+}
+
+void report(const std::string& op, size_t n, double overlap, const Measure& m, size_t elements,
+            double rss) {
+    std::cout << std::left << std::setw(14) << op << std::right << std::setw(10) << n
+              << std::setw(9) << std::fixed << std::setprecision(2) << overlap << std::setw(12)
+              << std::setprecision(2) << m.ns / elements << std::setw(14) << std::setprecision(1)
+              << m.allocs << std::setw(12) << rss << "\n";
+}
+
+void run(size_t n, double overlap) {
+    // A = {0, 2, 4, ...}, B shares the first overlap*n values of A and is odd afterwards
+    std::vector<int> A(n);
+    std::vector<int> B(n);
+    const size_t shared = static_cast<size_t>(overlap * n);
+    for (size_t i = 0; i < n; ++i) {
+        A[i] = static_cast<int>(2 * i);
+        B[i] = static_cast<int>(i < shared ? 2 * i : 2 * i + 1);
+    }
+
+    const int reps = static_cast<int>(std::max<size_t>(1, 1'000'000 / n));
+
+    const Measure construct =
+        measure(reps, [] { return 0; }, [&](int) { Set S{A}; });
+
+    const Set S1{A};
+    const Set S2{B};
+    const double rss = resident_MiB();
+
+    report("construct", n, overlap, construct, n, rss);
+
+    // is_member walks the list, so only a few random queries are timed
+    constexpr int queries = 16;
+    std::mt19937 gen{42};
+    std::uniform_int_distribution<int> dist{0, static_cast<int>(2 * n)};
+    std::vector<int> values(queries);
+    for (int& v : values) v = dist(gen);
+
+    const Measure member = measure(
+        reps, [] { return 0; },
+        [&](int) {
+            for (int v : values) sink = S1.is_member(v);
+        });
+    report("is_member", n, overlap, member, queries * n, rss);
+
+    const auto copy_S1 = [&] { return Set{S1}; };
+    report("union", n, overlap, measure(reps, copy_S1, [&](Set& S) { S += S2; }), 2 * n, rss);
+    report("intersection", n, overlap, measure(reps, copy_S1, [&](Set& S) { S *= S2; }), 2 * n,
+           rss);
+    report("difference", n, overlap, measure(reps, copy_S1, [&](Set& S) { S -= S2; }), 2 * n,
+           rss);
+
+    // S1 and S2 have the same cardinality, so S1 < S2 would only time the early exit
+    // S1 is a strict subset of S1 + S2 + {-1} for every overlap
+    const Set superset = S1 + S2 + Set{-1};
+    report("<=>", n, overlap,
+           measure(reps, [] { return 0; }, [&](int) { sink = (S1 < superset); }),
+           n + superset.cardinality(), rss);
+}
+
+}  // namespace
+
+/*
+ * Count allocations made by the operations under test
+ */
+void* operator new(size_t size) {
+    ++allocations;
+    if (void* p = std::malloc(size == 0 ? 1 : size)) {
+        return p;
+    }
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+int main(int argc, char* argv[]) {
+    const size_t max_size = (argc > 1) ? std::stoul(argv[1]) : 1'000'000;
+
+    std::cout << std::left << std::setw(14) << "operation" << std::right << std::setw(10) << "n"
+              << std::setw(9) << "overlap" << std::setw(12) << "ns/elem" << std::setw(14)
+              << "allocs/op" << std::setw(12) << "RSS (MiB)" << "\n";
+
+    for (size_t n = 1000; n <= max_size; n *= 10) {
+        for (double overlap : {0.0, 0.5, 1.0}) {
+            run(n, overlap);
+        }
+    }
+
+    std::cout << "Set nodes left: " << Set::get_count_nodes() << "\n";
+}